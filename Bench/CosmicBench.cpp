@@ -0,0 +1,728 @@
+// Headless performance harness for the grain engine and the full processor chain.
+//
+// Usage: CosmicBench [--quick] [--full] [--engine-only | --processor-only | --paint] [--json[=file]]
+//
+// Every case renders white noise offline, times each processBlock call and reports
+// ns/sample, grain throughput and the p50/p99/max block time both as a table on stdout
+// and (with --json) as machine-readable JSON. A bare --json prints the JSON on stdout
+// and moves the table to stderr, so the output can be piped straight into jq. --paint instead times the editor painting
+// into an image while the processor runs a grain cloud.
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
+
+#include "GrainEngine.h"
+#include "PluginEditor.h"
+#include "PluginProcessor.h"
+
+#include <array>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <numeric>
+#include <thread>
+#include <vector>
+
+namespace
+{
+using Clock = std::chrono::steady_clock;
+
+enum class BenchTarget
+{
+    engine,
+    processor
+};
+
+struct BenchCase
+{
+    BenchTarget target = BenchTarget::engine;
+    juce::String sweep;
+    double sampleRate = 48000.0;
+    int blockSize = 256;
+    float density = 64.0f;
+    float grainSizeMs = 120.0f;
+    float pitchJitter = 2.0f;
+    int renderThreads = 0;
+    GrainInterpolator::Quality interpolation = GrainInterpolator::Quality::linear;
+    bool stereoLink = false;        // Binary Stars: one grain per stereo pair of inputs
+    bool doublePrecision = false;   // process 64-bit buffers, as a host with a double mix engine would
+    int distortionOversampling = 0; // processor only, index into distortionOversamplingLabels
+    int reverbLines = 0;            // processor only, NebulaReverb line choice
+    double impulseSeconds = 0.0;    // processor only, Space Convolve with a synthetic response; 0 = off
+    bool realtimePacing = false;    // wait out each block's duration, so background threads keep pace
+    bool silentInput = false;       // processor only, digital silence: an idle instance in a large session
+};
+
+struct BenchResult
+{
+    BenchCase benchCase;
+    double nsPerSample = 0.0;
+    double grainSamplesPerSecond = 0.0;
+    double averageActiveGrains = 0.0;
+    double p50Micros = 0.0;
+    double p99Micros = 0.0;
+    double maxMicros = 0.0;
+    double cpuLoad = 0.0;
+    uint64_t grainsStolen = 0;
+    uint64_t grainsDropped = 0;
+    uint64_t lateTailBlocks = 0;
+    // Processor only: each stage's mean over the profiler's last window of blocks.
+    std::array<double, StageProfiler::numStages> stageMeanMicros {};
+};
+
+struct PaintResult
+{
+    juce::String mode;
+    int frames = 0;
+    double p50Micros = 0.0;
+    double p99Micros = 0.0;
+    double maxMicros = 0.0;
+};
+
+struct BenchSettings
+{
+    double warmupSeconds = 1.0;
+    double measureSeconds = 5.0;
+};
+
+constexpr double baselineSampleRate = 48000.0;
+constexpr int baselineBlockSize = 256;
+constexpr float baselineDensity = 64.0f;
+constexpr float baselineGrainSizeMs = 120.0f;
+constexpr float baselinePitchJitter = 2.0f;
+
+// The processor's Nebula Size parameter tops out lower than the engine's own clamp.
+constexpr float processorMaxGrainSizeMs = 500.0f;
+
+const char* targetName(BenchTarget target)
+{
+    return target == BenchTarget::engine ? "engine" : "processor";
+}
+
+const char* interpolationName(GrainInterpolator::Quality quality)
+{
+    return CosmicGrainDelayAudioProcessor::grainInterpolationLabels[static_cast<size_t>(quality)];
+}
+
+const char* precisionName(bool doublePrecision)
+{
+    return doublePrecision ? "double" : "float";
+}
+
+double percentile(const std::vector<double>& sorted, double fraction)
+{
+    if (sorted.empty())
+        return 0.0;
+
+    const auto index = static_cast<size_t>(fraction * static_cast<double>(sorted.size() - 1) + 0.5);
+    return sorted[juce::jmin(index, sorted.size() - 1)];
+}
+
+template <typename SampleType>
+void fillWithNoise(juce::AudioBuffer<SampleType>& buffer, juce::Random& random)
+{
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        auto* data = buffer.getWritePointer(channel);
+        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+            data[sample] = (random.nextFloat() * 2.0f - 1.0f) * 0.5f;
+    }
+}
+
+template <typename SampleType, typename RenderFn, typename ActiveGrainFn>
+BenchResult measureWith(const BenchCase& benchCase, const BenchSettings& settings, RenderFn&& render, ActiveGrainFn&& activeGrains)
+{
+    juce::AudioBuffer<SampleType> buffer(2, benchCase.blockSize);
+    juce::Random random(0x5eed);
+
+    const auto blocksFor = [&](double seconds)
+    {
+        return juce::jmax(1, static_cast<int>(seconds * benchCase.sampleRate / benchCase.blockSize));
+    };
+
+    const auto warmupBlocks = blocksFor(settings.warmupSeconds);
+    const auto measuredBlocks = blocksFor(settings.measureSeconds);
+
+    const auto blockDuration = std::chrono::nanoseconds(static_cast<int64_t>(benchCase.blockSize / benchCase.sampleRate * 1.0e9));
+
+    std::vector<double> blockNanos;
+    blockNanos.reserve(static_cast<size_t>(measuredBlocks));
+    double grainSamples = 0.0;
+
+    for (int block = 0; block < warmupBlocks + measuredBlocks; ++block)
+    {
+        if (benchCase.silentInput)
+            buffer.clear();
+        else
+            fillWithNoise(buffer, random);
+
+        const auto start = Clock::now();
+        render(buffer);
+        const auto end = Clock::now();
+
+        if (block >= warmupBlocks)
+        {
+            blockNanos.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+            grainSamples += static_cast<double>(activeGrains()) * benchCase.blockSize;
+        }
+
+        if (benchCase.realtimePacing)
+            std::this_thread::sleep_until(start + blockDuration);
+    }
+
+    const auto totalNanos = std::accumulate(blockNanos.begin(), blockNanos.end(), 0.0);
+    const auto totalSamples = static_cast<double>(measuredBlocks) * benchCase.blockSize;
+    const auto audioNanos = totalSamples / benchCase.sampleRate * 1.0e9;
+
+    std::sort(blockNanos.begin(), blockNanos.end());
+
+    BenchResult result;
+    result.benchCase = benchCase;
+    result.nsPerSample = totalNanos / totalSamples;
+    result.grainSamplesPerSecond = totalNanos > 0.0 ? grainSamples / (totalNanos * 1.0e-9) : 0.0;
+    result.averageActiveGrains = grainSamples / totalSamples;
+    result.p50Micros = percentile(blockNanos, 0.50) * 1.0e-3;
+    result.p99Micros = percentile(blockNanos, 0.99) * 1.0e-3;
+    result.maxMicros = blockNanos.empty() ? 0.0 : blockNanos.back() * 1.0e-3;
+    result.cpuLoad = totalNanos / audioNanos;
+    return result;
+}
+
+// render takes a float or a double buffer, whichever the case asks for.
+template <typename RenderFn, typename ActiveGrainFn>
+BenchResult measure(const BenchCase& benchCase, const BenchSettings& settings, RenderFn&& render, ActiveGrainFn&& activeGrains)
+{
+    if (benchCase.doublePrecision)
+        return measureWith<double>(benchCase, settings, render, activeGrains);
+    return measureWith<float>(benchCase, settings, render, activeGrains);
+}
+
+BenchResult runEngineCase(const BenchCase& benchCase, const BenchSettings& settings)
+{
+    GrainEngine engine;
+    engine.prepare({ benchCase.sampleRate, static_cast<juce::uint32>(benchCase.blockSize), 2 }, {}, benchCase.doublePrecision);
+    engine.setGrainSize(benchCase.grainSizeMs);
+    engine.setDensity(benchCase.density);
+    engine.setPitch(0.0f);
+    engine.setPitchJitter(benchCase.pitchJitter);
+    engine.setSpread(35.0f);
+    engine.setScatter(25.0f);
+    engine.setEnvelopeShape(0.5f);
+    engine.setFeedback(0.35f);
+    engine.setDelayTime(400.0f);
+    engine.setRenderThreads(benchCase.renderThreads);
+    engine.setParallelRendering(benchCase.renderThreads > 0);
+    engine.setInterpolation(benchCase.interpolation);
+    engine.setStereoLink(benchCase.stereoLink);
+    // The benchmark measures raw render cost, so the governor must not thin the cloud.
+    engine.getGovernor().setEnabled(false);
+
+    auto result = measure(benchCase, settings,
+                          [&](auto& buffer) { engine.processBlock(buffer); },
+                          [&] { return engine.getActiveGrainCount(); });
+
+    const auto counters = engine.getGovernor().getCounters();
+    result.grainsStolen = counters.stolen;
+    result.grainsDropped = counters.dropped;
+    return result;
+}
+
+void setParameter(juce::AudioProcessorValueTreeState& state, const juce::String& parameterID, float value)
+{
+    if (auto* parameter = state.getParameter(parameterID))
+        parameter->setValueNotifyingHost(parameter->convertTo0to1(value));
+}
+
+// Decaying stereo noise standing in for a large space; it falls by 60 dB over its length.
+void writeImpulseFile(const juce::File& file, double seconds, double sampleRate)
+{
+    const auto length = static_cast<int>(seconds * sampleRate);
+    juce::AudioBuffer<float> impulse(2, length);
+    juce::Random random(0x1a);
+
+    for (int channel = 0; channel < impulse.getNumChannels(); ++channel)
+    {
+        auto* data = impulse.getWritePointer(channel);
+        for (int sample = 0; sample < length; ++sample)
+            data[sample] = (random.nextFloat() * 2.0f - 1.0f) * std::exp(-6.9f * static_cast<float>(sample) / static_cast<float>(length));
+    }
+
+    auto stream = file.createOutputStream();
+    if (stream == nullptr)
+        return;
+
+    juce::WavAudioFormat format;
+    std::unique_ptr<juce::AudioFormatWriter> writer(format.createWriterFor(stream.get(), sampleRate, 2, 24, {}, 0));
+    if (writer == nullptr)
+        return;
+
+    stream.release(); // now owned by the writer
+    writer->writeFromAudioSampleBuffer(impulse, 0, length);
+}
+
+BenchResult runProcessorCase(const BenchCase& benchCase, const BenchSettings& settings)
+{
+    CosmicGrainDelayAudioProcessor processor;
+    auto& state = processor.getValueTreeState();
+    setParameter(state, "grainSize", benchCase.grainSizeMs);
+    setParameter(state, "density", benchCase.density);
+    setParameter(state, "grainPitchJitter", benchCase.pitchJitter);
+    setParameter(state, "distortionEnabled", 1.0f);
+    setParameter(state, "grainInterpolation", static_cast<float>(benchCase.interpolation));
+    setParameter(state, "grainStereoLink", benchCase.stereoLink ? 1.0f : 0.0f);
+    setParameter(state, "distortionOversampling", static_cast<float>(benchCase.distortionOversampling));
+    setParameter(state, "reverbLines", static_cast<float>(benchCase.reverbLines));
+
+    juce::TemporaryFile impulseFile(".wav");
+    if (benchCase.impulseSeconds > 0.0)
+    {
+        writeImpulseFile(impulseFile.getFile(), benchCase.impulseSeconds, benchCase.sampleRate);
+        setParameter(state, "reverbConvolution", 1.0f);
+    }
+
+    // Running non-realtime keeps the grain governor out of the measurement.
+    processor.setNonRealtime(true);
+    processor.setProcessingPrecision(benchCase.doublePrecision ? juce::AudioProcessor::doublePrecision
+                                                               : juce::AudioProcessor::singlePrecision);
+    processor.setRateAndBufferSizeDetails(benchCase.sampleRate, benchCase.blockSize);
+    processor.prepareToPlay(benchCase.sampleRate, benchCase.blockSize);
+
+    if (benchCase.impulseSeconds > 0.0)
+    {
+        // The response loads on the processor's background thread.
+        processor.loadImpulseResponse(impulseFile.getFile());
+        for (int waited = 0; !processor.hasImpulseResponse() && waited < 30000; waited += 10)
+            juce::Thread::sleep(10);
+    }
+
+    processor.setProfilingEnabled(true);
+
+    juce::MidiBuffer midi;
+    auto result = measure(benchCase, settings,
+                          [&](auto& buffer) { processor.processBlock(buffer, midi); },
+                          [&] { return processor.getActiveGrainCount(); });
+
+    const auto counters = processor.getGrainGovernor().getCounters();
+    result.grainsStolen = counters.stolen;
+    result.grainsDropped = counters.dropped;
+    result.lateTailBlocks = processor.getLateConvolutionBlocks();
+    const auto& profile = processor.acquireProfile();
+    for (size_t stage = 0; stage < StageProfiler::numStages; ++stage)
+        result.stageMeanMicros[stage] = profile.stages[stage].meanMicros;
+    processor.releaseResources();
+    return result;
+}
+
+// Paints the editor into an image at its 30 Hz frame rate, with the processor running a
+// grain cloud between frames so the visualiser has work to do. "cold" rebuilds the
+// cached layers every frame, as a resize would; "full" repaints the whole window from
+// the cache; "tick" repaints only the visualiser, which is what the timer asks for.
+std::vector<PaintResult> runPaintBenchmark(const BenchSettings& settings)
+{
+    constexpr double frameRate = 30.0;
+
+    CosmicGrainDelayAudioProcessor processor;
+    processor.setRateAndBufferSizeDetails(baselineSampleRate, baselineBlockSize);
+    processor.prepareToPlay(baselineSampleRate, baselineBlockSize);
+
+    std::unique_ptr<juce::AudioProcessorEditor> editorOwner(processor.createEditor());
+    auto& editor = dynamic_cast<CosmicGrainDelayAudioProcessorEditor&>(*editorOwner);
+
+    juce::AudioBuffer<float> buffer(2, baselineBlockSize);
+    juce::MidiBuffer midi;
+    juce::Random random(0x5eed);
+    juce::Image frame(juce::Image::ARGB, editor.getWidth(), editor.getHeight(), true);
+
+    const auto numFrames = juce::jmax(1, static_cast<int>((settings.warmupSeconds + settings.measureSeconds) * frameRate));
+    const auto warmupFrames = static_cast<int>(settings.warmupSeconds * frameRate);
+    const auto blocksPerFrame = juce::jmax(1, static_cast<int>(baselineSampleRate / frameRate / baselineBlockSize));
+
+    const auto measureMode = [&](const juce::String& mode, auto&& paintFrame)
+    {
+        std::vector<double> frameNanos;
+        for (int f = 0; f < numFrames; ++f)
+        {
+            for (int block = 0; block < blocksPerFrame; ++block)
+            {
+                fillWithNoise(buffer, random);
+                processor.processBlock(buffer, midi);
+            }
+            editor.advanceFrame();
+
+            const auto start = Clock::now();
+            paintFrame();
+            const auto end = Clock::now();
+
+            if (f >= warmupFrames)
+                frameNanos.push_back(static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+        }
+
+        std::sort(frameNanos.begin(), frameNanos.end());
+
+        PaintResult result;
+        result.mode = mode;
+        result.frames = static_cast<int>(frameNanos.size());
+        result.p50Micros = percentile(frameNanos, 0.50) * 1.0e-3;
+        result.p99Micros = percentile(frameNanos, 0.99) * 1.0e-3;
+        result.maxMicros = frameNanos.empty() ? 0.0 : frameNanos.back() * 1.0e-3;
+        return result;
+    };
+
+    std::vector<PaintResult> results;
+    results.push_back(measureMode("cold", [&]
+    {
+        editor.resized();
+        juce::Graphics g(frame);
+        editor.paintEntireComponent(g, true);
+    }));
+    results.push_back(measureMode("full", [&]
+    {
+        juce::Graphics g(frame);
+        editor.paintEntireComponent(g, true);
+    }));
+    results.push_back(measureMode("tick", [&]
+    {
+        juce::Graphics g(frame);
+        g.reduceClipRegion(editor.getVisualiserBounds());
+        editor.paintEntireComponent(g, true);
+    }));
+
+    editorOwner.reset();
+    processor.releaseResources();
+    return results;
+}
+
+BenchCase makeBaseline(BenchTarget target, const juce::String& sweep)
+{
+    BenchCase benchCase;
+    benchCase.target = target;
+    benchCase.sweep = sweep;
+    benchCase.sampleRate = baselineSampleRate;
+    benchCase.blockSize = baselineBlockSize;
+    benchCase.density = baselineDensity;
+    benchCase.grainSizeMs = baselineGrainSizeMs;
+    benchCase.pitchJitter = baselinePitchJitter;
+    return benchCase;
+}
+
+const std::vector<float> densities { 0.5f, 8.0f, 32.0f, 128.0f, 512.0f };
+const std::vector<float> grainSizes { 20.0f, 120.0f, 500.0f, 1000.0f };
+const std::vector<float> pitchJitters { 0.0f, 2.0f, 12.0f };
+const std::vector<int> blockSizes { 16, 64, 256, 1024, 4096 };
+const std::vector<double> sampleRates { 44100.0, 48000.0, 96000.0, 192000.0 };
+const std::vector<int> renderThreadCounts { 0, 1, 2, 3 };
+const std::vector<double> impulseLengths { 2.0, 10.0, 30.0 };
+
+// One-factor-at-a-time sweeps around the baseline, plus a worst-case corner that
+// saturates the grain pool.
+std::vector<BenchCase> makeSweepCases(BenchTarget target)
+{
+    std::vector<BenchCase> cases;
+    const auto maxGrainSize = target == BenchTarget::engine ? 1000.0f : processorMaxGrainSizeMs;
+
+    for (auto value : densities)
+    {
+        auto c = makeBaseline(target, "density");
+        c.density = value;
+        cases.push_back(c);
+    }
+
+    for (auto value : grainSizes)
+    {
+        if (value > maxGrainSize)
+            continue;
+
+        auto c = makeBaseline(target, "grainSize");
+        c.grainSizeMs = value;
+        cases.push_back(c);
+    }
+
+    for (auto value : pitchJitters)
+    {
+        auto c = makeBaseline(target, "pitchJitter");
+        c.pitchJitter = value;
+        cases.push_back(c);
+    }
+
+    for (auto value : blockSizes)
+    {
+        auto c = makeBaseline(target, "blockSize");
+        c.blockSize = value;
+        cases.push_back(c);
+    }
+
+    for (auto value : sampleRates)
+    {
+        auto c = makeBaseline(target, "sampleRate");
+        c.sampleRate = value;
+        cases.push_back(c);
+    }
+
+    auto stress = makeBaseline(target, "stress");
+    stress.density = 512.0f;
+    stress.grainSizeMs = maxGrainSize;
+    stress.pitchJitter = 12.0f;
+    stress.sampleRate = 96000.0;
+    stress.blockSize = 64;
+    cases.push_back(stress);
+
+    for (int quality = 0; quality < GrainInterpolator::numQualities; ++quality)
+    {
+        auto c = makeBaseline(target, "interp");
+        c.interpolation = static_cast<GrainInterpolator::Quality>(quality);
+        cases.push_back(c);
+    }
+
+    // The baseline in both precisions, to pick one per session.
+    for (auto useDouble : { false, true })
+    {
+        auto c = makeBaseline(target, "precision");
+        c.doublePrecision = useDouble;
+        cases.push_back(c);
+    }
+
+    // The same qualities with Binary Stars, row for row against the interp sweep.
+    for (int quality = 0; quality < GrainInterpolator::numQualities; ++quality)
+    {
+        auto c = makeBaseline(target, "link");
+        c.interpolation = static_cast<GrainInterpolator::Quality>(quality);
+        c.stereoLink = true;
+        cases.push_back(c);
+    }
+
+    // Meteor Burn cost at each oversampling factor and Nebula cost at each network
+    // size; the engine has neither stage.
+    if (target == BenchTarget::processor)
+    {
+        for (int choice = 0; choice < SoftClipper::numOversamplingChoices; ++choice)
+        {
+            auto c = makeBaseline(target, "burnOS");
+            c.distortionOversampling = choice;
+            cases.push_back(c);
+        }
+
+        for (int choice = 0; choice < NebulaReverb::numLineChoices; ++choice)
+        {
+            auto c = makeBaseline(target, "nebula");
+            c.reverbLines = choice;
+            cases.push_back(c);
+        }
+
+        // Space Convolve at a small buffer, in real time so the tail thread runs as it
+        // would in a host and any block it misses shows up as late.
+        for (auto seconds : impulseLengths)
+        {
+            auto c = makeBaseline(target, "convolve");
+            c.blockSize = 64;
+            c.impulseSeconds = seconds;
+            c.realtimePacing = true;
+            cases.push_back(c);
+        }
+
+        // Idle instance at the smallest and largest buffers, once every stage's tail
+        // has run out and it sleeps.
+        for (auto block : { 64, 1024 })
+        {
+            auto c = makeBaseline(target, "idle");
+            c.blockSize = block;
+            c.silentInput = true;
+            cases.push_back(c);
+        }
+    }
+
+    // Worker-pool scaling on a saturated cloud. The processor cases stay on the
+    // audio thread, which is its default.
+    if (target == BenchTarget::engine)
+    {
+        for (auto value : renderThreadCounts)
+        {
+            auto c = makeBaseline(target, "threads");
+            c.density = 512.0f;
+            c.grainSizeMs = maxGrainSize;
+            c.sampleRate = 96000.0;
+            c.renderThreads = value;
+            cases.push_back(c);
+        }
+    }
+
+    return cases;
+}
+
+std::vector<BenchCase> makeFullGridCases()
+{
+    std::vector<BenchCase> cases;
+
+    for (auto rate : sampleRates)
+        for (auto block : blockSizes)
+            for (auto density : densities)
+                for (auto size : grainSizes)
+                    for (auto jitter : pitchJitters)
+                    {
+                        auto c = makeBaseline(BenchTarget::engine, "grid");
+                        c.sampleRate = rate;
+                        c.blockSize = block;
+                        c.density = density;
+                        c.grainSizeMs = size;
+                        c.pitchJitter = jitter;
+                        cases.push_back(c);
+                    }
+
+    return cases;
+}
+
+void printTableHeader(FILE* out)
+{
+    std::fprintf(out, "%-9s %-11s %7s %5s %7s %7s %6s %3s %-8s %-6s %3s %3s %4s | %8s %12s %8s %9s %9s %9s %7s %5s\n",
+                "target", "sweep", "rate", "block", "density", "sizeMs", "jitter", "thr", "interp", "format", "os", "rvb", "irS",
+                "ns/smp", "grainSmp/s", "grains", "p50 us", "p99 us", "max us", "load%", "late");
+    std::fprintf(out, "%s\n", juce::String::repeatedString("-", 175).toRawUTF8());
+}
+
+void printTableRow(FILE* out, const BenchResult& r)
+{
+    const auto& c = r.benchCase;
+    std::fprintf(out, "%-9s %-11s %7.0f %5d %7.1f %7.0f %6.1f %3d %-8s %-6s %3s %3d %4.0f | %8.2f %12.3e %8.1f %9.2f %9.2f %9.2f %7.2f %5llu\n",
+                targetName(c.target), c.sweep.toRawUTF8(), c.sampleRate, c.blockSize, c.density, c.grainSizeMs, c.pitchJitter,
+                c.renderThreads, interpolationName(c.interpolation), precisionName(c.doublePrecision),
+                CosmicGrainDelayAudioProcessor::distortionOversamplingLabels[static_cast<size_t>(c.distortionOversampling)],
+                NebulaReverb::linesForChoice(c.reverbLines), c.impulseSeconds,
+                r.nsPerSample, r.grainSamplesPerSecond, r.averageActiveGrains, r.p50Micros, r.p99Micros, r.maxMicros,
+                r.cpuLoad * 100.0, static_cast<unsigned long long>(r.lateTailBlocks));
+    std::fflush(out);
+}
+
+juce::var toJson(const BenchResult& r)
+{
+    const auto& c = r.benchCase;
+    auto* object = new juce::DynamicObject();
+    object->setProperty("target", targetName(c.target));
+    object->setProperty("sweep", c.sweep);
+    object->setProperty("sampleRate", c.sampleRate);
+    object->setProperty("blockSize", c.blockSize);
+    object->setProperty("density", c.density);
+    object->setProperty("grainSizeMs", c.grainSizeMs);
+    object->setProperty("pitchJitter", c.pitchJitter);
+    object->setProperty("renderThreads", c.renderThreads);
+    object->setProperty("interpolation", interpolationName(c.interpolation));
+    object->setProperty("stereoLink", c.stereoLink);
+    object->setProperty("precision", precisionName(c.doublePrecision));
+    object->setProperty("distortionOversampling", CosmicGrainDelayAudioProcessor::distortionOversamplingLabels[static_cast<size_t>(c.distortionOversampling)]);
+    object->setProperty("reverbLines", NebulaReverb::linesForChoice(c.reverbLines));
+    object->setProperty("impulseSeconds", c.impulseSeconds);
+    object->setProperty("silentInput", c.silentInput);
+    object->setProperty("nsPerSample", r.nsPerSample);
+    object->setProperty("grainSamplesPerSecond", r.grainSamplesPerSecond);
+    object->setProperty("averageActiveGrains", r.averageActiveGrains);
+    object->setProperty("p50BlockMicros", r.p50Micros);
+    object->setProperty("p99BlockMicros", r.p99Micros);
+    object->setProperty("maxBlockMicros", r.maxMicros);
+    object->setProperty("cpuLoad", r.cpuLoad);
+    object->setProperty("grainsStolen", static_cast<juce::int64>(r.grainsStolen));
+    object->setProperty("grainsDropped", static_cast<juce::int64>(r.grainsDropped));
+    object->setProperty("lateTailBlocks", static_cast<juce::int64>(r.lateTailBlocks));
+
+    if (c.target == BenchTarget::processor)
+    {
+        auto* stages = new juce::DynamicObject();
+        for (size_t stage = 0; stage < StageProfiler::numStages; ++stage)
+            stages->setProperty(StageProfiler::stageNames[stage], r.stageMeanMicros[stage]);
+        object->setProperty("stageMeanMicros", juce::var(stages));
+    }
+    return juce::var(object);
+}
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    BenchSettings settings;
+    if (args.containsOption("--quick"))
+    {
+        settings.warmupSeconds = 0.25;
+        settings.measureSeconds = 1.0;
+    }
+
+    const auto runPaint = args.containsOption("--paint");
+    const auto runEngine = !runPaint && !args.containsOption("--processor-only");
+    const auto runProcessor = !runPaint && !args.containsOption("--engine-only");
+
+    const auto writeJson = args.containsOption("--json");
+    const auto jsonDestination = args.getValueForOption("--json");
+    auto* const table = writeJson && jsonDestination.isEmpty() ? stderr : stdout;
+
+    std::vector<BenchCase> cases;
+    if (runEngine)
+    {
+        auto engineCases = args.containsOption("--full") ? makeFullGridCases() : makeSweepCases(BenchTarget::engine);
+        cases.insert(cases.end(), engineCases.begin(), engineCases.end());
+    }
+    if (runProcessor)
+    {
+        auto processorCases = makeSweepCases(BenchTarget::processor);
+        cases.insert(cases.end(), processorCases.begin(), processorCases.end());
+    }
+
+    juce::Array<juce::var> results;
+    if (!cases.empty())
+        printTableHeader(table);
+
+    for (const auto& benchCase : cases)
+    {
+        const auto result = benchCase.target == BenchTarget::engine ? runEngineCase(benchCase, settings)
+                                                                    : runProcessorCase(benchCase, settings);
+        printTableRow(table, result);
+        results.add(toJson(result));
+    }
+
+    juce::Array<juce::var> paintResults;
+    if (runPaint)
+    {
+        std::fprintf(table, "%-6s %7s | %9s %9s %9s\n", "paint", "frames", "p50 us", "p99 us", "max us");
+        std::fprintf(table, "%s\n", juce::String::repeatedString("-", 46).toRawUTF8());
+
+        for (const auto& r : runPaintBenchmark(settings))
+        {
+            std::fprintf(table, "%-6s %7d | %9.1f %9.1f %9.1f\n", r.mode.toRawUTF8(), r.frames, r.p50Micros, r.p99Micros, r.maxMicros);
+
+            auto* object = new juce::DynamicObject();
+            object->setProperty("mode", r.mode);
+            object->setProperty("frames", r.frames);
+            object->setProperty("p50FrameMicros", r.p50Micros);
+            object->setProperty("p99FrameMicros", r.p99Micros);
+            object->setProperty("maxFrameMicros", r.maxMicros);
+            paintResults.add(juce::var(object));
+        }
+    }
+
+    if (writeJson)
+    {
+        auto* report = new juce::DynamicObject();
+        report->setProperty("benchmark", "CosmicBench");
+        report->setProperty("warmupSeconds", settings.warmupSeconds);
+        report->setProperty("measureSeconds", settings.measureSeconds);
+        report->setProperty("results", results);
+        if (runPaint)
+            report->setProperty("paint", paintResults);
+
+        const auto json = juce::JSON::toString(juce::var(report));
+        if (jsonDestination.isEmpty())
+        {
+            std::printf("%s\n", json.toRawUTF8());
+        }
+        else
+        {
+            const auto file = juce::File::getCurrentWorkingDirectory().getChildFile(jsonDestination);
+            if (!file.replaceWithText(json))
+            {
+                std::fprintf(stderr, "CosmicBench: could not write %s\n", file.getFullPathName().toRawUTF8());
+                return 1;
+            }
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,808 @@
+#include "ConvolutionReverb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <utility>
+#include <vector>
+
+namespace
+{
+// Partition sizes, shortest first. Only the first runs on the audio thread; at 128
+// samples a 64-sample callback costs one small FFT pair per channel.
+constexpr std::array<int, 3> partitionSizes { 128, 1024, 8192 };
+
+constexpr double crossfadeSeconds = 0.05;
+
+// Trailing samples this far below the peak (about -90 dB) are trimmed, so padded
+// files cost nothing.
+constexpr float silenceThreshold = 3.0e-5f;
+
+// Energy per channel a loaded response is normalised to, which keeps it roughly level
+// with the network mode at its default Horizon.
+constexpr double targetEnergy = 4.0;
+
+// Blocks the loader's resampler pulls at a time.
+constexpr int resampleBlockSize = 4096;
+
+int divideRoundingUp(int64_t numerator, int denominator) noexcept
+{
+    return static_cast<int>((numerator + denominator - 1) / denominator);
+}
+
+// Each partition is transformed with an FFT twice its length.
+int fftOrderFor(int partitionSize) noexcept
+{
+    int order = 1;
+    while ((1 << order) < 2 * partitionSize)
+        ++order;
+    return order;
+}
+
+// Spectra are stored split: the real parts of bins 0..N/2, then their imaginary parts,
+// so the complex multiply-accumulate below vectorises.
+void splitSpectrum(const float* interleaved, float* split, int bins) noexcept
+{
+    for (int i = 0; i < bins; ++i)
+    {
+        split[i] = interleaved[2 * i];
+        split[bins + i] = interleaved[2 * i + 1];
+    }
+}
+
+void interleaveSpectrum(const float* split, float* interleaved, int bins) noexcept
+{
+    for (int i = 0; i < bins; ++i)
+    {
+        interleaved[2 * i] = split[i];
+        interleaved[2 * i + 1] = split[bins + i];
+    }
+}
+
+void multiplyAccumulate(float* accumulator, const float* x, const float* h, int bins) noexcept
+{
+    auto* accRe = accumulator;
+    auto* accIm = accumulator + bins;
+    const auto* xRe = x;
+    const auto* xIm = x + bins;
+    const auto* hRe = h;
+    const auto* hIm = h + bins;
+
+    for (int i = 0; i < bins; ++i)
+    {
+        accRe[i] += xRe[i] * hRe[i] - xIm[i] * hIm[i];
+        accIm[i] += xRe[i] * hIm[i] + xIm[i] * hRe[i];
+    }
+}
+
+// Uniformly partitioned overlap-add convolution of one channel with one section of
+// the response, keeping past input spectra in a frequency-domain delay line.
+class PartitionConvolver
+{
+public:
+    PartitionConvolver(int partitionSizeToUse, int numPartitionsToUse, const float* spectraToUse)
+        : partitionSize(partitionSizeToUse),
+          bins(partitionSizeToUse + 1),
+          numPartitions(numPartitionsToUse),
+          spectra(spectraToUse),
+          fft(fftOrderFor(partitionSizeToUse)),
+          fftBuffer(static_cast<size_t>(4 * partitionSize)),
+          history(static_cast<size_t>(numPartitions * 2 * bins)),
+          spectrum(static_cast<size_t>(2 * bins)),
+          accumulator(static_cast<size_t>(2 * bins)),
+          work(static_cast<size_t>(2 * bins)),
+          current(static_cast<size_t>(partitionSize)),
+          overlap(static_cast<size_t>(partitionSize))
+    {
+    }
+
+    int getRemainingInPartition() const noexcept { return partitionSize - fill; }
+
+    // Audio thread, first section only: convolves count new samples with no latency.
+    // The partially filled partition is transformed on every call and combined with
+    // the older partitions' contribution, which is summed once per partition.
+    void processHead(const float* input, float* output, int count) noexcept
+    {
+        std::copy(input, input + count, current.begin() + fill);
+        transform(current.data(), fill + count);
+
+        std::copy(accumulator.begin(), accumulator.end(), work.begin());
+        multiplyAccumulate(work.data(), spectrum.data(), spectra, bins);
+        const auto* result = inverse(work.data());
+
+        for (int i = 0; i < count; ++i)
+            output[i] = result[fill + i] + overlap[static_cast<size_t>(fill + i)];
+
+        fill += count;
+        if (fill < partitionSize)
+            return;
+
+        std::copy(result + partitionSize, result + 2 * partitionSize, overlap.begin());
+        pushSpectrum();
+        accumulateHistory(1);
+        fill = 0;
+    }
+
+    // Tail thread: convolves one full partition of input into output.
+    void processBlock(const float* input, float* output) noexcept
+    {
+        transform(input, partitionSize);
+        pushSpectrum();
+        accumulateHistory(0);
+        const auto* result = inverse(accumulator.data());
+
+        for (int i = 0; i < partitionSize; ++i)
+            output[i] = result[i] + overlap[static_cast<size_t>(i)];
+
+        std::copy(result + partitionSize, result + 2 * partitionSize, overlap.begin());
+    }
+
+    // Tail thread: stands in for a block that was dropped.
+    void skipBlock() noexcept
+    {
+        std::fill(spectrum.begin(), spectrum.end(), 0.0f);
+        pushSpectrum();
+        std::fill(overlap.begin(), overlap.end(), 0.0f);
+    }
+
+private:
+    void transform(const float* samples, int count) noexcept
+    {
+        std::copy(samples, samples + count, fftBuffer.begin());
+        std::fill(fftBuffer.begin() + count, fftBuffer.end(), 0.0f);
+        fft.performRealOnlyForwardTransform(fftBuffer.data(), true);
+        splitSpectrum(fftBuffer.data(), spectrum.data(), bins);
+    }
+
+    const float* inverse(const float* source) noexcept
+    {
+        interleaveSpectrum(source, fftBuffer.data(), bins);
+        fft.performRealOnlyInverseTransform(fftBuffer.data());
+        return fftBuffer.data();
+    }
+
+    void pushSpectrum() noexcept
+    {
+        newest = (newest + 1) % numPartitions;
+        std::copy(spectrum.begin(), spectrum.end(), history.begin() + newest * 2 * bins);
+    }
+
+    // Sums partitions [firstPartition, numPartitions), pairing partition p with the
+    // spectrum pushed p - firstPartition blocks ago.
+    void accumulateHistory(int firstPartition) noexcept
+    {
+        std::fill(accumulator.begin(), accumulator.end(), 0.0f);
+        for (int p = firstPartition; p < numPartitions; ++p)
+        {
+            const auto index = (newest - (p - firstPartition) + numPartitions) % numPartitions;
+            multiplyAccumulate(accumulator.data(), history.data() + index * 2 * bins, spectra + p * 2 * bins, bins);
+        }
+    }
+
+    const int partitionSize;
+    const int bins;
+    const int numPartitions;
+    const float* spectra;
+    juce::dsp::FFT fft;
+
+    std::vector<float> fftBuffer;
+    std::vector<float> history;
+    std::vector<float> spectrum;
+    std::vector<float> accumulator;
+    std::vector<float> work;
+    std::vector<float> current;
+    std::vector<float> overlap;
+    int newest = 0;
+    int fill = 0;
+};
+}
+
+// An impulse response cut into sections of increasing partition size, transformed
+// once at load time. Immutable once built, so engines can share it.
+struct ConvolutionReverb::Kernel
+{
+    struct Stage
+    {
+        int partitionSize = 0;
+        int offset = 0;         // first response sample this section covers
+        int numPartitions = 0;
+        int ringBlocks = 0;     // tail sections: blocks held in the input and output rings
+        // One entry per response channel, numPartitions split spectra each.
+        std::vector<std::vector<float>> spectra;
+    };
+
+    std::vector<Stage> stages;
+    int numChannels = 0;
+    int length = 0;
+};
+
+// Convolution state for one response. The audio thread runs the head and hands
+// completed input blocks of each tail section to the tail thread through a ring; the
+// tail thread writes each finished block to an output ring slot tagged with its index.
+class ConvolutionReverb::Engine
+{
+public:
+    Engine(std::shared_ptr<const Kernel> kernelToUse, int numChannelsToUse)
+        : kernel(std::move(kernelToUse)), numChannels(numChannelsToUse)
+    {
+        for (size_t s = 0; s < kernel->stages.size(); ++s)
+        {
+            const auto& stage = kernel->stages[s];
+            auto& convolvers = s == 0 ? head : tails.emplace_back(std::make_unique<TailStage>(stage, numChannels))->convolvers;
+
+            // A mono response feeds both channels.
+            for (int channel = 0; channel < numChannels; ++channel)
+            {
+                const auto& spectra = stage.spectra[static_cast<size_t>(juce::jmin(channel, kernel->numChannels - 1))];
+                convolvers.push_back(std::make_unique<PartitionConvolver>(stage.partitionSize, stage.numPartitions, spectra.data()));
+            }
+        }
+    }
+
+    // Audio thread: convolves the channels in place. Returns true if a tail block was
+    // completed, in which case the tail thread needs waking.
+    bool process(float* const* channels, int count, int numSamples, std::atomic<uint64_t>& lateBlocks) noexcept
+    {
+        count = juce::jmin(count, numChannels);
+        auto submitted = false;
+
+        for (auto& tail : tails)
+        {
+            const auto start = static_cast<int>(position % tail->ringSize);
+            const auto first = juce::jmin(numSamples, tail->ringSize - start);
+            for (int channel = 0; channel < count; ++channel)
+            {
+                auto* ring = tail->inputRings[static_cast<size_t>(channel)].data();
+                std::copy(channels[channel], channels[channel] + first, ring + start);
+                std::copy(channels[channel] + first, channels[channel] + numSamples, ring);
+            }
+
+            const auto completeBlocks = (position + numSamples) / tail->layout.partitionSize;
+            if (completeBlocks > tail->submittedBlocks.load(std::memory_order_relaxed))
+            {
+                tail->submittedBlocks.store(completeBlocks, std::memory_order_release);
+                submitted = true;
+            }
+        }
+
+        for (int channel = 0; channel < count; ++channel)
+        {
+            auto& convolver = *head[static_cast<size_t>(channel)];
+            auto* samples = channels[channel];
+            for (int done = 0; done < numSamples;)
+            {
+                const auto length = juce::jmin(numSamples - done, convolver.getRemainingInPartition());
+                convolver.processHead(samples + done, samples + done, length);
+                done += length;
+            }
+        }
+
+        for (auto& tail : tails)
+            addTail(*tail, channels, count, numSamples, lateBlocks);
+
+        position += numSamples;
+        return submitted;
+    }
+
+    // Tail thread: convolves every block submitted since the last call.
+    void processTail() noexcept
+    {
+        for (auto& tail : tails)
+        {
+            const auto& layout = tail->layout;
+            const auto submitted = tail->submittedBlocks.load(std::memory_order_acquire);
+
+            for (; tail->nextBlock < submitted; ++tail->nextBlock)
+            {
+                const auto block = tail->nextBlock;
+
+                // Far enough behind that the audio thread has already passed this
+                // block's output: skip it rather than fall further behind.
+                if (submitted - block > layout.ringBlocks - 2)
+                {
+                    for (auto& convolver : tail->convolvers)
+                        convolver->skipBlock();
+                    continue;
+                }
+
+                const auto slot = static_cast<int>(block % layout.ringBlocks);
+                for (size_t channel = 0; channel < tail->convolvers.size(); ++channel)
+                    tail->convolvers[channel]->processBlock(tail->inputRings[channel].data() + slot * layout.partitionSize,
+                                                            tail->outputRings[channel].data() + slot * layout.partitionSize);
+
+                // If the audio thread lapped the input ring meanwhile, the block was built
+                // from overwritten input; leave it unpublished so it plays as a late one.
+                if (tail->submittedBlocks.load(std::memory_order_acquire) - block >= layout.ringBlocks)
+                    continue;
+
+                tail->slotBlocks[static_cast<size_t>(slot)].store(block, std::memory_order_release);
+            }
+        }
+    }
+
+private:
+    struct TailStage
+    {
+        TailStage(const Kernel::Stage& layoutToUse, int numChannels)
+            : layout(layoutToUse),
+              ringSize(layoutToUse.ringBlocks * layoutToUse.partitionSize),
+              inputRings(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(ringSize))),
+              outputRings(static_cast<size_t>(numChannels), std::vector<float>(static_cast<size_t>(ringSize))),
+              slotBlocks(std::make_unique<std::atomic<int64_t>[]>(static_cast<size_t>(layoutToUse.ringBlocks)))
+        {
+            for (int slot = 0; slot < layout.ringBlocks; ++slot)
+                slotBlocks[static_cast<size_t>(slot)].store(-1);
+        }
+
+        const Kernel::Stage& layout;
+        const int ringSize;
+        std::vector<std::unique_ptr<PartitionConvolver>> convolvers;
+        std::vector<std::vector<float>> inputRings;
+        std::vector<std::vector<float>> outputRings;
+        // Index of the block each output slot holds, published once it is complete.
+        std::unique_ptr<std::atomic<int64_t>[]> slotBlocks;
+        std::atomic<int64_t> submittedBlocks { 0 };
+        int64_t nextBlock = 0;  // tail thread
+        int64_t lateBlock = -1; // audio thread: a block found missing stays silent throughout
+    };
+
+    void addTail(TailStage& tail, float* const* channels, int count, int numSamples, std::atomic<uint64_t>& lateBlocks) noexcept
+    {
+        const auto& layout = tail.layout;
+
+        for (int done = 0; done < numSamples;)
+        {
+            const auto relative = position + done - layout.offset;
+            if (relative < 0)
+            {
+                done += static_cast<int>(juce::jmin<int64_t>(numSamples - done, -relative));
+                continue;
+            }
+
+            const auto block = relative / layout.partitionSize;
+            const auto within = static_cast<int>(relative % layout.partitionSize);
+            const auto length = juce::jmin(numSamples - done, layout.partitionSize - within);
+            const auto slot = static_cast<int>(block % layout.ringBlocks);
+
+            if (block != tail.lateBlock && tail.slotBlocks[static_cast<size_t>(slot)].load(std::memory_order_acquire) != block)
+            {
+                tail.lateBlock = block;
+                lateBlocks.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            if (block != tail.lateBlock)
+                for (int channel = 0; channel < count; ++channel)
+                    juce::FloatVectorOperations::add(channels[channel] + done,
+                                                     tail.outputRings[static_cast<size_t>(channel)].data() + slot * layout.partitionSize + within,
+                                                     length);
+
+            done += length;
+        }
+    }
+
+    const std::shared_ptr<const Kernel> kernel;
+    const int numChannels;
+    std::vector<std::unique_ptr<PartitionConvolver>> head;
+    std::vector<std::unique_ptr<TailStage>> tails;
+    int64_t position = 0;
+};
+
+class ConvolutionReverb::TailThread : public juce::Thread
+{
+public:
+    explicit TailThread(ConvolutionReverb& ownerToUse)
+        : juce::Thread("Cosmic Convolution Tail"), owner(ownerToUse)
+    {
+    }
+
+    ~TailThread() override
+    {
+        halt();
+    }
+
+    void halt()
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(2000);
+    }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            // The audio thread signals once per completed tail block; the timeout only
+            // bounds how long a retired engine waits to be freed.
+            wakeUp.wait(50.0);
+
+            for (auto& slot : owner.tailEngines)
+                if (auto* engine = slot.load(std::memory_order_acquire))
+                    engine->processTail();
+
+            // The audio thread removes an engine from tailEngines before retiring it, so
+            // once this pass is done nothing can reach a retired engine any more.
+            for (auto& slot : owner.retiredEngines)
+                std::unique_ptr<Engine> retired(slot.exchange(nullptr, std::memory_order_acq_rel));
+        }
+    }
+
+    juce::WaitableEvent wakeUp;
+
+private:
+    ConvolutionReverb& owner;
+};
+
+ConvolutionReverb::ConvolutionReverb()
+    : tailThread(std::make_unique<TailThread>(*this))
+{
+    formatManager.registerBasicFormats();
+}
+
+ConvolutionReverb::~ConvolutionReverb()
+{
+    tailThread->halt();
+    destroyEngines();
+}
+
+void ConvolutionReverb::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    tailThread->halt();
+
+    {
+        // Holding the lock while the generation moves on stops the loader from
+        // publishing an engine built for the old rate or block size.
+        const juce::ScopedLock lock(requestLock);
+        sampleRate = spec.sampleRate;
+        maxBlockSize = juce::jmax(1, static_cast<int>(spec.maximumBlockSize));
+        requestGeneration.fetch_add(1, std::memory_order_release);
+    }
+
+    destroyEngines();
+
+    fadeLength = juce::jmax(1, juce::roundToInt(spec.sampleRate * crossfadeSeconds));
+    fadeRemaining = 0;
+    fadeBuffer.setSize(maxEngineChannels, juce::jmax(1, static_cast<int>(spec.maximumBlockSize)));
+    width = targetWidth;
+
+    tailThread->startThread(juce::Thread::Priority::high);
+}
+
+void ConvolutionReverb::loadImpulseResponse(const juce::File& file)
+{
+    const juce::ScopedLock lock(requestLock);
+    requestedFile = file;
+    requestGeneration.fetch_add(1, std::memory_order_release);
+}
+
+juce::File ConvolutionReverb::getImpulseResponseFile() const
+{
+    const juce::ScopedLock lock(requestLock);
+    return requestedFile;
+}
+
+int ConvolutionReverb::useTimeSlice()
+{
+    const auto generation = requestGeneration.load(std::memory_order_acquire);
+    if (generation != loadedGeneration)
+    {
+        juce::File file;
+        double rate = 0.0;
+        int blockSize = 0;
+        {
+            const juce::ScopedLock lock(requestLock);
+            file = requestedFile;
+            rate = sampleRate;
+            blockSize = maxBlockSize;
+        }
+
+        loadedGeneration = generation;
+        kernel = file == juce::File() ? nullptr : buildKernel(file, rate, blockSize);
+        impulseSeconds.store(kernel != nullptr ? kernel->length / rate : 0.0, std::memory_order_relaxed);
+
+        // Each engine channel keeps an input spectrum history as large as one channel
+        // of the partitioned response.
+        size_t bytes = 0;
+        if (kernel != nullptr)
+            for (const auto& stage : kernel->stages)
+                if (!stage.spectra.empty())
+                    bytes += (stage.spectra.size() + maxEngineChannels) * stage.spectra.front().size() * sizeof(float);
+        memoryBytes.store(bytes, std::memory_order_relaxed);
+        impulseLoaded.store(kernel != nullptr, std::memory_order_release);
+        resetRequested.store(false);
+
+        if (kernel != nullptr)
+            publishEngine(std::make_unique<Engine>(kernel, maxEngineChannels));
+        return 0;
+    }
+
+    if (resetRequested.exchange(false) && kernel != nullptr)
+        publishEngine(std::make_unique<Engine>(kernel, maxEngineChannels));
+
+    return 20;
+}
+
+std::shared_ptr<const ConvolutionReverb::Kernel> ConvolutionReverb::buildKernel(const juce::File& file, double rate, int blockSize)
+{
+    std::unique_ptr<juce::AudioFormatReader> reader(formatManager.createReaderFor(file));
+    if (reader == nullptr || reader->sampleRate <= 0.0 || reader->lengthInSamples <= 0 || rate <= 0.0)
+        return nullptr;
+
+    const auto numChannels = juce::jlimit(1, maxEngineChannels, static_cast<int>(reader->numChannels));
+    const auto fileLength = static_cast<int>(juce::jmin(reader->lengthInSamples,
+                                                        static_cast<juce::int64>(maxImpulseSeconds * reader->sampleRate)));
+
+    juce::AudioBuffer<float> impulse(numChannels, fileLength);
+    reader->read(&impulse, 0, fileLength, 0, true, numChannels > 1);
+
+    if (std::abs(reader->sampleRate - rate) > 0.01)
+    {
+        const auto ratio = reader->sampleRate / rate;
+        const auto length = static_cast<int>(std::ceil(fileLength / ratio));
+
+        juce::MemoryAudioSource source(impulse, false);
+        juce::ResamplingAudioSource resampler(&source, false, numChannels);
+        resampler.setResamplingRatio(ratio);
+        resampler.prepareToPlay(resampleBlockSize, rate);
+
+        juce::AudioBuffer<float> resampled(numChannels, length);
+        for (int start = 0; start < length; start += resampleBlockSize)
+            resampler.getNextAudioBlock(juce::AudioSourceChannelInfo(&resampled, start, juce::jmin(resampleBlockSize, length - start)));
+
+        impulse = std::move(resampled);
+    }
+
+    const auto peak = impulse.getMagnitude(0, impulse.getNumSamples());
+    if (peak <= 0.0f)
+        return nullptr;
+
+    int length = 0;
+    double energy = 0.0;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* samples = impulse.getReadPointer(channel);
+        for (int i = impulse.getNumSamples(); --i >= length;)
+            if (std::abs(samples[i]) > peak * silenceThreshold)
+            {
+                length = i + 1;
+                break;
+            }
+
+        for (int i = 0; i < impulse.getNumSamples(); ++i)
+            energy += static_cast<double>(samples[i]) * samples[i];
+    }
+
+    const auto gain = static_cast<float>(std::sqrt(targetEnergy * numChannels / energy));
+
+    auto result = std::make_shared<Kernel>();
+    result->numChannels = numChannels;
+    result->length = length;
+
+    for (size_t s = 0, offset = 0; s < partitionSizes.size() && static_cast<int>(offset) < length; ++s)
+    {
+        Kernel::Stage stage;
+        stage.partitionSize = partitionSizes[s];
+        stage.offset = static_cast<int>(offset);
+
+        // The next section may only start once the tail thread has had a whole block
+        // of it plus a host callback to compute it; this one covers the gap until then.
+        auto end = length;
+        if (s + 1 < partitionSizes.size())
+        {
+            const auto next = partitionSizes[s + 1];
+            end = juce::jmin(end, next + juce::jmax(next, blockSize));
+        }
+
+        stage.numPartitions = juce::jmax(1, divideRoundingUp(end - stage.offset, stage.partitionSize));
+        if (s > 0)
+            stage.ringBlocks = 2 + divideRoundingUp(stage.offset + blockSize, stage.partitionSize);
+
+        const auto bins = stage.partitionSize + 1;
+        juce::dsp::FFT fft(fftOrderFor(stage.partitionSize));
+        std::vector<float> buffer(static_cast<size_t>(4 * stage.partitionSize));
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto& spectra = stage.spectra.emplace_back(static_cast<size_t>(stage.numPartitions * 2 * bins));
+            const auto* samples = impulse.getReadPointer(channel);
+
+            for (int p = 0; p < stage.numPartitions; ++p)
+            {
+                const auto start = stage.offset + p * stage.partitionSize;
+                const auto count = juce::jlimit(0, stage.partitionSize, length - start);
+
+                std::fill(buffer.begin(), buffer.end(), 0.0f);
+                for (int i = 0; i < count; ++i)
+                    buffer[static_cast<size_t>(i)] = samples[start + i] * gain;
+
+                fft.performRealOnlyForwardTransform(buffer.data(), true);
+                splitSpectrum(buffer.data(), spectra.data() + p * 2 * bins, bins);
+            }
+        }
+
+        offset += static_cast<size_t>(stage.numPartitions * stage.partitionSize);
+        result->stages.push_back(std::move(stage));
+    }
+
+    return result;
+}
+
+void ConvolutionReverb::publishEngine(std::unique_ptr<Engine> engine)
+{
+    const juce::ScopedLock lock(requestLock);
+
+    // prepare() or a newer load request has moved on since this engine was built.
+    if (requestGeneration.load(std::memory_order_acquire) != loadedGeneration)
+        return;
+
+    // An engine still pending was never seen by the audio thread, so it can go here.
+    std::unique_ptr<Engine> superseded(pendingEngine.exchange(engine.release(), std::memory_order_acq_rel));
+}
+
+void ConvolutionReverb::reset() noexcept
+{
+    retire(fadingEngine);
+    retire(activeEngine);
+    fadingEngine = nullptr;
+    activeEngine = nullptr;
+    fadeRemaining = 0;
+    resetRequested.store(true, std::memory_order_release);
+}
+
+void ConvolutionReverb::setWidth(float newWidth) noexcept
+{
+    targetWidth = juce::jlimit(0.0f, 1.0f, newWidth);
+}
+
+void ConvolutionReverb::retire(Engine* engine) noexcept
+{
+    if (engine == nullptr)
+        return;
+
+    for (auto& slot : tailEngines)
+    {
+        auto* expected = engine;
+        slot.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+    }
+
+    for (auto& slot : retiredEngines)
+    {
+        Engine* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, engine, std::memory_order_acq_rel))
+            return;
+    }
+
+    // The tail thread has not freed the previous batch yet; offer it again next block.
+    for (auto& waiting : unretiredEngines)
+    {
+        if (waiting == nullptr)
+        {
+            waiting = engine;
+            return;
+        }
+    }
+
+    jassertfalse;
+}
+
+void ConvolutionReverb::updateTailEngines() noexcept
+{
+    tailEngines[0].store(activeEngine, std::memory_order_release);
+    tailEngines[1].store(fadingEngine, std::memory_order_release);
+}
+
+void ConvolutionReverb::destroyEngines()
+{
+    for (auto& slot : tailEngines)
+        slot.store(nullptr);
+
+    std::unique_ptr<Engine> active(activeEngine), fading(fadingEngine), pending(pendingEngine.exchange(nullptr));
+    activeEngine = nullptr;
+    fadingEngine = nullptr;
+
+    for (auto& slot : retiredEngines)
+        std::unique_ptr<Engine> retired(slot.exchange(nullptr));
+
+    for (auto& waiting : unretiredEngines)
+    {
+        std::unique_ptr<Engine> retired(waiting);
+        waiting = nullptr;
+    }
+}
+
+void ConvolutionReverb::process(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto numChannels = static_cast<int>(juce::jmin(block.getNumChannels(), static_cast<size_t>(maxEngineChannels)));
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+
+    for (auto& waiting : unretiredEngines)
+        if (auto* engine = std::exchange(waiting, nullptr))
+            retire(engine);
+
+    if (auto* next = pendingEngine.exchange(nullptr, std::memory_order_acq_rel))
+    {
+        retire(fadingEngine);
+        fadingEngine = activeEngine;
+        activeEngine = next;
+        fadeRemaining = fadingEngine != nullptr ? fadeLength : 0;
+        updateTailEngines();
+    }
+
+    std::array<float*, maxEngineChannels> channels {};
+    for (int channel = 0; channel < numChannels; ++channel)
+        channels[static_cast<size_t>(channel)] = block.getChannelPointer(static_cast<size_t>(channel));
+
+    auto submitted = false;
+
+    if (fadingEngine != nullptr)
+    {
+        std::array<float*, maxEngineChannels> faded {};
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            faded[static_cast<size_t>(channel)] = fadeBuffer.getWritePointer(channel);
+            juce::FloatVectorOperations::copy(faded[static_cast<size_t>(channel)], channels[static_cast<size_t>(channel)], numSamples);
+        }
+
+        submitted = fadingEngine->process(faded.data(), numChannels, numSamples, lateTailBlocks);
+    }
+
+    if (activeEngine != nullptr)
+    {
+        submitted = activeEngine->process(channels.data(), numChannels, numSamples, lateTailBlocks) || submitted;
+    }
+    else
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::clear(channels[static_cast<size_t>(channel)], numSamples);
+    }
+
+    if (fadingEngine != nullptr)
+    {
+        const auto fadeSamples = juce::jmin(numSamples, fadeRemaining);
+        const auto step = 1.0f / static_cast<float>(fadeLength);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* out = channels[static_cast<size_t>(channel)];
+            const auto* old = fadeBuffer.getReadPointer(channel);
+            for (int i = 0; i < fadeSamples; ++i)
+            {
+                const auto gain = static_cast<float>(fadeLength - fadeRemaining + i) * step;
+                out[i] = old[i] + (out[i] - old[i]) * gain;
+            }
+        }
+
+        fadeRemaining -= fadeSamples;
+        if (fadeRemaining == 0)
+        {
+            retire(fadingEngine);
+            fadingEngine = nullptr;
+            updateTailEngines();
+        }
+    }
+
+    if (submitted)
+        tailThread->wakeUp.signal();
+
+    const auto startWidth = width;
+    width = targetWidth;
+
+    if (numChannels == 2 && numSamples > 0)
+    {
+        auto* left = channels[0];
+        auto* right = channels[1];
+        const auto widthStep = (width - startWidth) / static_cast<float>(numSamples);
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            const auto w = startWidth + widthStep * static_cast<float>(i + 1);
+            const auto wet1 = 0.5f * (1.0f + w);
+            const auto wet2 = 0.5f * (1.0f - w);
+            const auto l = left[i];
+            const auto r = right[i];
+            left[i] = l * wet1 + r * wet2;
+            right[i] = r * wet1 + l * wet2;
+        }
+    }
+
+    for (auto channel = static_cast<size_t>(numChannels); channel < block.getNumChannels(); ++channel)
+        juce::FloatVectorOperations::clear(block.getChannelPointer(channel), numSamples);
+}
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <juce_audio_formats/juce_audio_formats.h>
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// Nebula convolution mode: convolves the reverb send with an impulse response loaded
+// from disk, using non-uniform partitioned FFT convolution. The start of the response
+// is split into short partitions that the audio thread convolves with no added
+// latency. Later sections use longer partitions and run on a dedicated tail thread.
+// Each tail section starts late enough that the tail thread has at least one host
+// callback to deliver a block after its input is complete. The audio thread never
+// waits for it: a block that is not ready in time stays silent and is counted.
+//
+// Decoding, resampling and partitioning a response run on the processor's background
+// thread. The finished engine is handed to the audio thread, which crossfades to it;
+// engines the audio thread retires are freed on the tail thread.
+class ConvolutionReverb : public juce::TimeSliceClient
+{
+public:
+    // Longer responses are truncated; 30 s covers the largest spaces.
+    static constexpr double maxImpulseSeconds = 30.0;
+
+    ConvolutionReverb();
+    ~ConvolutionReverb() override;
+
+    // Message thread, while process() is not running: sizes the partitions for the
+    // largest block and rebuilds any loaded response at the new sample rate.
+    void prepare(const juce::dsp::ProcessSpec& spec);
+
+    // Message thread: loads the file in the background. An empty File unloads.
+    void loadImpulseResponse(const juce::File& file);
+    juce::File getImpulseResponseFile() const;
+
+    // Any thread.
+    bool hasImpulseResponse() const noexcept { return impulseLoaded.load(std::memory_order_acquire); }
+    uint64_t getLateTailBlocks() const noexcept { return lateTailBlocks.load(std::memory_order_relaxed); }
+    // Length of the loaded response after trimming, 0 when none is loaded.
+    double getTailSeconds() const noexcept { return impulseSeconds.load(std::memory_order_relaxed); }
+    // Approximate heap use of the loaded response and the engine running it.
+    size_t getMemoryBytes() const noexcept { return memoryBytes.load(std::memory_order_relaxed); }
+
+    // Audio thread: drops the current tail. A fresh engine for the same response
+    // follows shortly; the output is silent until it arrives.
+    void reset() noexcept;
+
+    // Audio thread: width glides over the next block.
+    void setWidth(float newWidth) noexcept;
+
+    // Audio thread: replaces the first one or two channels with the wet signal and
+    // silences any others.
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    int useTimeSlice() override;
+
+private:
+    struct Kernel;
+    class Engine;
+    class TailThread;
+
+    static constexpr int maxEngineChannels = 2;
+    static constexpr int numRetireSlots = 8;
+
+    std::shared_ptr<const Kernel> buildKernel(const juce::File& file, double sampleRate, int maxBlockSize);
+    void publishEngine(std::unique_ptr<Engine> engine);
+    void retire(Engine* engine) noexcept;
+    void updateTailEngines() noexcept;
+    void destroyEngines();
+
+    juce::AudioFormatManager formatManager;
+    std::unique_ptr<TailThread> tailThread;
+
+    // Written on the message thread; read by the loader under the lock.
+    mutable juce::CriticalSection requestLock;
+    juce::File requestedFile;
+    double sampleRate = 44100.0;
+    int maxBlockSize = 512;
+    std::atomic<uint32_t> requestGeneration { 0 };
+
+    // Loader (background thread) state.
+    uint32_t loadedGeneration = 0;
+    std::shared_ptr<const Kernel> kernel;
+
+    std::atomic<Engine*> pendingEngine { nullptr };
+    std::atomic<bool> resetRequested { false };
+    std::atomic<bool> impulseLoaded { false };
+    std::atomic<double> impulseSeconds { 0.0 };
+    std::atomic<size_t> memoryBytes { 0 };
+    std::atomic<uint64_t> lateTailBlocks { 0 };
+
+    // Engines whose tails the tail thread should run, and engines it should free.
+    std::array<std::atomic<Engine*>, 2> tailEngines {};
+    std::array<std::atomic<Engine*>, numRetireSlots> retiredEngines {};
+
+    // Audio thread only.
+    Engine* activeEngine = nullptr;
+    Engine* fadingEngine = nullptr;
+    std::array<Engine*, numRetireSlots> unretiredEngines {};
+    int fadeLength = 1;
+    int fadeRemaining = 0;
+    juce::AudioBuffer<float> fadeBuffer;
+    float width = 1.0f;
+    float targetWidth = 1.0f;
+};
@@ -6,6 +6,24 @@
 
 namespace
 {
+constexpr double smoothingSeconds = 0.02;
+
+// Mixes start on a cache line, so every frame's registers are aligned.
+constexpr size_t mixAlignment = 64;
+constexpr size_t mixAlignmentPadding = mixAlignment / sizeof(float);
+
+// The feedback ramp is always float; a double ring scales by it sample by sample.
+void multiplyByRamp(float* ring, const float* ramp, int numSamples) noexcept
+{
+    juce::FloatVectorOperations::multiply(ring, ramp, numSamples);
+}
+
+void multiplyByRamp(double* ring, const float* ramp, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+        ring[i] *= static_cast<double>(ramp[i]);
+}
+
 constexpr float millisecondsToSamples(float ms, double sampleRate)
 {
     return static_cast<float>((ms / 1000.0f) * static_cast<float>(sampleRate));
@@ -22,51 +40,196 @@ GrainEngine::GrainEngine()
     resetPool();
 }
 
-void GrainEngine::prepare(const juce::dsp::ProcessSpec& spec)
+GrainEngine::~GrainEngine() = default;
+
+void GrainEngine::prepare(const juce::dsp::ProcessSpec& spec, const juce::AudioChannelSet& outputLayout, bool useDoublePrecision)
 {
     sampleRate = spec.sampleRate;
-    const auto delayBufferSize = static_cast<int>(millisecondsToSamples(2000.0f, sampleRate));
-    delayBuffer.setSize((int) spec.numChannels, delayBufferSize);
-    delayBuffer.clear();
+    panner.setLayout(outputLayout.isDisabled() ? juce::AudioChannelSet::canonicalChannelSet(static_cast<int>(spec.numChannels))
+                                               : outputLayout);
+    spawnIntervalDensity = -1.0f;
+    maxBlockSize = juce::jmax(1, static_cast<int>(spec.maximumBlockSize));
+    delayLength = static_cast<int>(millisecondsToSamples(2000.0f, sampleRate));
+    delayBufferSize = juce::nextPowerOfTwo(delayLength + maxBlockSize + 2 * delayGuardSamples);
+    delayMask = delayBufferSize - 1;
+    doublePrecision = useDoublePrecision;
+    numDelayChannels = static_cast<int>(spec.numChannels);
+
+    // The other precision's line gives its memory back.
+    const auto ringChannels = doublePrecision ? 0 : numDelayChannels;
+    floatDelay.history.setSize(ringChannels, delayBufferSize + 2 * delayGuardSamples);
+    doubleDelay.history.setSize(numDelayChannels - ringChannels, delayBufferSize + 2 * delayGuardSamples);
+    clearDelayLines();
+    tapPositions.assign(static_cast<size_t>(maxBlockSize), 0);
+    prepareMixes();
+    spawnFrames.assign(static_cast<size_t>(maxBlockSize), 0);
     writePosition = 0;
     spawnAccumulator = 0.0f;
-    smoothedDelaySamples.reset(sampleRate, 0.02);
-    smoothedDelaySamples.setCurrentAndTargetValue(millisecondsToSamples(delayMs, sampleRate));
+    smoothing.prepare(sampleRate, maxBlockSize, smoothingSeconds);
+    snapSmoothedParameters();
+    windowBank.rebuildIfNeeded();
+    windowEnergy = windowBank.acquireTable().meanSquare;
+    governor.prepare(sampleRate, nominalGrainCapacity);
     resetPool();
 }
 
 void GrainEngine::reset()
 {
-    delayBuffer.clear();
+    clearDelayLines();
     writePosition = 0;
     spawnAccumulator = 0.0f;
-    smoothedDelaySamples.setCurrentAndTargetValue(millisecondsToSamples(delayMs, sampleRate));
+    snapSmoothedParameters();
+    windowBank.rebuildIfNeeded();
+    resetPool();
+}
+
+void GrainEngine::snapSmoothedParameters() noexcept
+{
+    smoothing.setCurrentAndTarget(smoothedGrainSize, grainSizeMs);
+    smoothing.setCurrentAndTarget(smoothedDensity, density);
+    smoothing.setCurrentAndTarget(smoothedPitch, pitch);
+    smoothing.setCurrentAndTarget(smoothedSpread, spreadMs);
+    smoothing.setCurrentAndTarget(smoothedScatter, scatterMs);
+    smoothing.setCurrentAndTarget(smoothedPitchJitter, pitchJitter);
+    smoothing.setCurrentAndTarget(smoothedFeedback, feedback);
+    smoothing.setCurrentAndTarget(smoothedDelay, millisecondsToSamples(delayMs, sampleRate));
+}
+
+void GrainEngine::clear()
+{
+    clearDelayLines();
+    spawnAccumulator = 0.0f;
     resetPool();
 }
 
+void GrainEngine::clearDelayLines()
+{
+    floatDelay.history.clear();
+    doubleDelay.history.clear();
+}
+
+float GrainEngine::getPeakGain() const noexcept
+{
+    // Each grain plays at most unity gain into any output, and the interpolators
+    // overshoot a full-scale input by well under 2x.
+    constexpr float interpolationHeadroom = 2.0f;
+
+    const auto longestGrainSeconds = juce::jmax(10.0f, grainSizeMs + 0.5f * spreadMs) * 0.001f;
+    const auto overlap = std::ceil(density * longestGrainSeconds) * static_cast<float>(juce::jmax(1, numDelayChannels));
+    return interpolationHeadroom * juce::jlimit(1.0f, static_cast<float>(maxGrains), overlap);
+}
+
+float GrainEngine::getTypicalGain() const noexcept
+{
+    const auto meanGrainSeconds = juce::jmax(10.0f, grainSizeMs) * 0.001f;
+    const auto overlap = density * meanGrainSeconds;
+    return std::sqrt(juce::jmax(1.0f, overlap * windowEnergy));
+}
+
+double GrainEngine::getTailSeconds(float level, float threshold) const noexcept
+{
+    const auto ringSeconds = static_cast<double>(delayLength) / sampleRate;
+
+    // Grains read material at most delay + scatter old, plus the delay glide. A grain
+    // fast and long enough to overtake the write head reads material up to a whole ring
+    // old, which sits untouched until the write head comes round again.
+    const auto longestGrainSeconds = juce::jmax(10.0f, grainSizeMs + 0.5f * spreadMs) * 0.001f;
+    const auto fastestRate = semitoneToRate(pitch + 0.5f * pitchJitter);
+    auto seconds = (delayMs + scatterMs) * 0.001 + 0.02;
+    if (fastestRate * longestGrainSeconds >= delayMs * 0.001f)
+        seconds = ringSeconds;
+
+    // Each pass of the write head scales what it finds by the feedback.
+    if (feedback > 0.0f && level > threshold)
+        seconds += ringSeconds * std::ceil(std::log(threshold / level) / std::log(feedback));
+
+    return seconds;
+}
+
+void GrainEngine::setRenderThreads(int numWorkers)
+{
+    numWorkers = juce::jmax(0, numWorkers);
+    if (numWorkers == getNumRenderThreads())
+        return;
+
+    // The replacement pool and its chunk mixes are built before the lock and the old
+    // ones destroyed after it, so the audio thread is only ever locked out for the swap.
+    std::unique_ptr<GrainRenderPool> pool;
+    std::vector<float> storage;
+    if (numWorkers > 0)
+    {
+        pool = std::make_unique<GrainRenderPool>(numWorkers, sampleRate, maxBlockSize);
+        pool->setWorkgroup(audioWorkgroup);
+        storage.assign(maxRenderChunks * getMixSize() + mixAlignmentPadding, 0.0f);
+    }
+
+    const juce::SpinLock::ScopedLockType lock(renderPoolLock);
+    renderPool.swap(pool);
+    chunkMixStorage.swap(storage);
+    chunkMixes = renderPool != nullptr ? juce::snapPointerToAlignment(chunkMixStorage.data(), mixAlignment) : nullptr;
+}
+
+size_t GrainEngine::getMixSize() const noexcept
+{
+    return static_cast<size_t>(juce::jmax(1, maxBlockSize)) * mixStride;
+}
+
+void GrainEngine::prepareMixes()
+{
+    const auto numOutputs = static_cast<size_t>(panner.getNumChannels());
+    mixStride = (numOutputs + laneWidth - 1) / laneWidth * laneWidth;
+    const auto mixSize = getMixSize();
+
+    mixStorage.assign(mixSize + mixAlignmentPadding, 0.0f);
+    mix = juce::snapPointerToAlignment(mixStorage.data(), mixAlignment);
+
+    if (renderPool != nullptr)
+    {
+        chunkMixStorage.assign(maxRenderChunks * mixSize + mixAlignmentPadding, 0.0f);
+        chunkMixes = juce::snapPointerToAlignment(chunkMixStorage.data(), mixAlignment);
+    }
+    else
+    {
+        std::vector<float>().swap(chunkMixStorage);
+        chunkMixes = nullptr;
+    }
+}
+
+void GrainEngine::setAudioWorkgroup(const juce::AudioWorkgroup& workgroupToJoin)
+{
+    audioWorkgroup = workgroupToJoin;
+    if (renderPool != nullptr)
+        renderPool->setWorkgroup(audioWorkgroup);
+}
+
 void GrainEngine::setGrainSize(float milliseconds)
 {
     grainSizeMs = juce::jlimit(10.0f, 1000.0f, milliseconds);
+    smoothing.setTarget(smoothedGrainSize, grainSizeMs);
 }
 
 void GrainEngine::setDensity(float grainsPerSecond)
 {
     density = juce::jlimit(0.5f, 512.0f, grainsPerSecond);
+    smoothing.setTarget(smoothedDensity, density);
 }
 
 void GrainEngine::setPitch(float semitones)
 {
     pitch = juce::jlimit(-24.0f, 24.0f, semitones);
+    smoothing.setTarget(smoothedPitch, pitch);
 }
 
 void GrainEngine::setSpread(float spread)
 {
     spreadMs = juce::jlimit(0.0f, 500.0f, spread);
+    smoothing.setTarget(smoothedSpread, spreadMs);
 }
 
 void GrainEngine::setFeedback(float feedbackAmount)
 {
     feedback = juce::jlimit(0.0f, 0.98f, feedbackAmount);
+    smoothing.setTarget(smoothedFeedback, feedback);
 }
 
 void GrainEngine::setWetLevel(float wetAmount)
@@ -79,268 +242,902 @@ void GrainEngine::setWetLevel(float wetAmount)
 void GrainEngine::setDelayTime(float milliseconds)
 {
     delayMs = juce::jlimit(1.0f, 1500.0f, milliseconds);
-    smoothedDelaySamples.setTargetValue(millisecondsToSamples(delayMs, sampleRate));
+    smoothing.setTarget(smoothedDelay, millisecondsToSamples(delayMs, sampleRate));
 }
 
 void GrainEngine::setScatter(float milliseconds)
 {
     scatterMs = juce::jlimit(0.0f, 500.0f, milliseconds);
-    scatterSamples = static_cast<size_t>(juce::roundToInt(std::min(millisecondsToSamples(scatterMs, sampleRate),
-        static_cast<float>(delayBuffer.getNumSamples()))));
+    smoothing.setTarget(smoothedScatter, scatterMs);
 }
 
 void GrainEngine::setEnvelopeShape(float shape)
 {
     envelopeShape = juce::jlimit(0.0f, 1.0f, shape);
+    windowBank.requestShape(windowShape, envelopeShape);
+}
+
+void GrainEngine::setWindowShape(GrainWindowBank::Shape shape)
+{
+    windowShape = shape;
+    windowBank.requestShape(windowShape, envelopeShape);
 }
 
 void GrainEngine::setPitchJitter(float semitones)
 {
     pitchJitter = juce::jlimit(0.0f, 12.0f, semitones);
+    smoothing.setTarget(smoothedPitchJitter, pitchJitter);
 }
 
 void GrainEngine::resetPool()
 {
     // Pool reset keeps allocation predictable and avoids per-sample heap churn
     // when we scale up to hundreds of overlapping grains.
+    lanes = GrainLanes{};
     activeGrainCount = 0;
-    freeGrainCount = maxGrains;
+    releasingGrainCount = 0;
+    sampleClock = 0;
+    nextReleaseSample = std::numeric_limits<int64_t>::max();
 
-    for (size_t i = 0; i < maxGrains; ++i)
+    // The editor's view empties along with the pool.
+    auto& snapshot = visualSnapshots.getWriteBuffer();
+    snapshot.grainCount = 0;
+    snapshot.activeGrains = 0;
+    visualSnapshots.publish();
+}
+
+bool GrainEngine::allocateGrain(size_t& laneOut)
+{
+    if (activeGrainCount >= maxGrains)
+        return false;
+
+    laneOut = activeGrainCount++;
+    return true;
+}
+
+void GrainEngine::releaseLane(size_t lane)
+{
+    if (lane >= activeGrainCount)
+        return;
+
+    const auto last = activeGrainCount - 1;
+
+    if (lanes.releasing[lane])
+        --releasingGrainCount;
+
+    if (lane != last)
     {
-        grainPool[i] = Grain{};
-        grainPool[i].active = false;
-        activeIndices[i] = 0;
-        freeIndices[i] = static_cast<uint16_t>(maxGrains - 1 - i);
+        lanes.readOffset[lane] = lanes.readOffset[last];
+        lanes.phase[lane] = lanes.phase[last];
+        lanes.advance[lane] = lanes.advance[last];
+        lanes.envelope[lane] = lanes.envelope[last];
+        lanes.envelopeIncrement[lane] = lanes.envelopeIncrement[last];
+        std::copy_n(lanes.outputGains.data() + last * GrainPanner::maxChannels, GrainPanner::maxChannels,
+                    lanes.outputGains.data() + lane * GrainPanner::maxChannels);
+        std::copy_n(lanes.pairedGains.data() + last * GrainPanner::maxChannels, GrainPanner::maxChannels,
+                    lanes.pairedGains.data() + lane * GrainPanner::maxChannels);
+        lanes.loudestGain[lane] = lanes.loudestGain[last];
+        lanes.channel[lane] = lanes.channel[last];
+        lanes.pairedChannel[lane] = lanes.pairedChannel[last];
+        lanes.linked[lane] = lanes.linked[last];
+        lanes.startSample[lane] = lanes.startSample[last];
+        lanes.endSample[lane] = lanes.endSample[last];
+        lanes.pitchSemitone[lane] = lanes.pitchSemitone[last];
+        lanes.pan[lane] = lanes.pan[last];
+        lanes.releasing[lane] = lanes.releasing[last];
+        lanes.sincBand[lane] = lanes.sincBand[last];
     }
 
-    visualSnapshots[0] = VisualSnapshot{};
-    visualSnapshots[1] = VisualSnapshot{};
-    visualSnapshotIndex.store(0, std::memory_order_relaxed);
+    // Park the vacated lane: no gain and no movement, so it can ride along in the
+    // trailing SIMD group without producing output or drifting its read offset.
+    lanes.readOffset[last] = 0.0f;
+    lanes.phase[last] = 0.0f;
+    lanes.advance[last] = 0.0f;
+    lanes.envelope[last] = 0.0f;
+    lanes.envelopeIncrement[last] = 0.0f;
+    std::fill_n(lanes.outputGains.data() + last * GrainPanner::maxChannels, GrainPanner::maxChannels, 0.0f);
+    std::fill_n(lanes.pairedGains.data() + last * GrainPanner::maxChannels, GrainPanner::maxChannels, 0.0f);
+    lanes.loudestGain[last] = 0.0f;
+    lanes.channel[last] = 0;
+    lanes.pairedChannel[last] = 0;
+    lanes.linked[last] = false;
+    lanes.releasing[last] = false;
+    lanes.sincBand[last] = 0;
+
+    --activeGrainCount;
 }
 
-GrainEngine::Grain* GrainEngine::allocateGrain(size_t& indexOut)
+void GrainEngine::releaseFinishedGrains()
 {
-    if (freeGrainCount == 0)
-        return nullptr;
+    nextReleaseSample = std::numeric_limits<int64_t>::max();
 
-    auto slot = freeIndices[--freeGrainCount];
-    indexOut = static_cast<size_t>(slot);
-    auto& grain = grainPool[indexOut];
-    grain = Grain{};
-    grain.active = true;
-    activeIndices[activeGrainCount++] = static_cast<uint16_t>(indexOut);
-    return &grain;
+    size_t lane = 0;
+    while (lane < activeGrainCount)
+    {
+        if (lanes.endSample[lane] <= sampleClock)
+        {
+            releaseLane(lane);
+            continue;
+        }
+
+        nextReleaseSample = std::min(nextReleaseSample, lanes.endSample[lane]);
+        ++lane;
+    }
 }
 
-void GrainEngine::releaseGrainAtActiveIndex(size_t activeListIndex)
+void GrainEngine::stealGrains(size_t count, const GrainWindowBank::Table& windowTable)
 {
-    if (activeListIndex >= activeGrainCount)
+    // Only grains that are already sounding and not yet fading are candidates; every
+    // lane here started before the current block, as stealing runs ahead of spawning.
+    size_t numCandidates = 0;
+    const bool oldestFirst = governor.getStealPolicy() == GrainGovernor::StealPolicy::oldest;
+
+    for (size_t lane = 0; lane < activeGrainCount; ++lane)
+    {
+        if (lanes.releasing[lane])
+            continue;
+
+        if (oldestFirst)
+        {
+            stealScores[lane] = static_cast<float>(lanes.startSample[lane] - sampleClock);
+        }
+        else
+        {
+            // A grain still fading in is judged by the level it is heading for, so
+            // freshly spawned grains are not the first to go.
+            auto level = GrainWindowBank::lookup(windowTable, lanes.envelope[lane]);
+            if (lanes.envelope[lane] < 0.5f)
+                level = juce::jmax(level, GrainWindowBank::lookup(windowTable, 0.5f));
+            stealScores[lane] = level * lanes.loudestGain[lane];
+        }
+
+        stealCandidates[numCandidates++] = static_cast<uint16_t>(lane);
+    }
+
+    count = juce::jmin(count, numCandidates);
+    if (count == 0)
         return;
 
-    const auto poolIndex = activeIndices[activeListIndex];
-    grainPool[poolIndex].active = false;
+    // Lowest score first: the quietest grains, or the ones that started longest ago.
+    const auto byScore = [this](uint16_t a, uint16_t b) { return stealScores[a] < stealScores[b]; };
+    auto* first = stealCandidates.data();
+    if (count < numCandidates)
+        std::nth_element(first, first + count, first + numCandidates, byScore);
 
-    if (activeListIndex != activeGrainCount - 1)
-        activeIndices[activeListIndex] = activeIndices[activeGrainCount - 1];
+    for (size_t i = 0; i < count; ++i)
+        beginSteal(stealCandidates[i], windowTable);
 
-    --activeGrainCount;
-    freeIndices[freeGrainCount++] = poolIndex;
+    governor.grainsStolen(count);
+}
+
+void GrainEngine::beginSteal(size_t lane, const GrainWindowBank::Table& windowTable)
+{
+    // Fade the grain out by running the rest of its window quickly. The window is
+    // first moved to the point on its falling edge with the same level as now, so
+    // the jump is inaudible even for skewed shapes.
+    const auto fadeSamples = juce::jmax(16.0f, millisecondsToSamples(5.0f, sampleRate));
+    const auto position = juce::jlimit(0.0f, 1.0f, lanes.envelope[lane]);
+    const auto level = GrainWindowBank::lookup(windowTable, position);
+
+    auto fadeStart = 1.0f;
+    constexpr int searchSteps = 64;
+    for (int step = searchSteps - 1; step >= 0; --step)
+    {
+        const auto candidate = static_cast<float>(step) / static_cast<float>(searchSteps);
+        if (candidate <= position || GrainWindowBank::lookup(windowTable, candidate) >= level)
+        {
+            fadeStart = juce::jmax(position, candidate);
+            break;
+        }
+    }
+
+    lanes.envelope[lane] = fadeStart;
+    lanes.envelopeIncrement[lane] = (1.0f - fadeStart) / fadeSamples;
+    lanes.endSample[lane] = std::min(lanes.endSample[lane], sampleClock + static_cast<int64_t>(std::ceil(fadeSamples)));
+    lanes.releasing[lane] = true;
+    ++releasingGrainCount;
+
+    nextReleaseSample = std::min(nextReleaseSample, lanes.endSample[lane]);
 }
 
 void GrainEngine::updateSpawnInterval(int numChannels)
+{
+    const auto currentDensity = smoothing.getCurrent(smoothedDensity);
+    if (currentDensity == spawnIntervalDensity && numChannels == spawnIntervalChannels)
+        return;
+
+    spawnIntervalDensity = currentDensity;
+    spawnIntervalChannels = numChannels;
+    spawnIntervalSamples = spawnIntervalFor(currentDensity, numChannels);
+}
+
+float GrainEngine::spawnIntervalFor(float grainsPerSecond, int numChannels) const noexcept
 {
     // Treat the density control as a global grains-per-second value and derive
     // per-channel spawn intervals so stereo instances stay predictable.
     const auto channelCount = juce::jmax(1, numChannels);
-    const auto effectiveDensity = juce::jmax(0.5f, density);
+    const auto effectiveDensity = juce::jmax(0.5f, grainsPerSecond);
     const auto eventsPerSecond = effectiveDensity / static_cast<float>(channelCount);
 
     if (eventsPerSecond <= 0.0f)
-    {
-        spawnIntervalSamples = std::numeric_limits<float>::max();
-        return;
-    }
+        return std::numeric_limits<float>::max();
 
-    spawnIntervalSamples = static_cast<float>(sampleRate) / eventsPerSecond;
-    spawnIntervalSamples = juce::jmax(1.0f, spawnIntervalSamples);
+    return juce::jmax(1.0f, static_cast<float>(sampleRate) / eventsPerSecond);
 }
 
-void GrainEngine::processBlock(juce::AudioBuffer<float>& buffer)
+template <typename SampleType>
+void GrainEngine::processBlock(juce::AudioBuffer<SampleType>& buffer)
 {
-    if (buffer.getNumChannels() == 0)
+    // The delay line only exists in the precision prepare() was given.
+    constexpr auto isDouble = std::is_same_v<SampleType, double>;
+    jassert(isDouble == doublePrecision);
+    if (buffer.getNumChannels() == 0 || maxBlockSize == 0 || isDouble != doublePrecision)
         return;
 
     const auto numSamples = buffer.getNumSamples();
+    const auto& windowTable = windowBank.acquireTable();
+    windowEnergy = windowTable.meanSquare;
+
+    governor.blockStarted();
+
+    for (int start = 0; start < numSamples; start += maxBlockSize)
+        processChunk(buffer, start, juce::jmin(maxBlockSize, numSamples - start), windowTable);
+
+    governor.blockFinished(numSamples, activeGrainCount);
+    updateVisualSnapshot();
+}
+
+template <typename SampleType>
+void GrainEngine::processChunk(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples,
+                               const GrainWindowBank::Table& windowTable)
+{
     const auto numChannels = buffer.getNumChannels();
-    const auto delayBufferSize = delayBuffer.getNumSamples();
-    auto channelWritePointers = buffer.getArrayOfWritePointers();
-    auto delayWritePointers = delayBuffer.getArrayOfWritePointers();
-    const auto totalChannels = juce::jmin(numChannels, delayBuffer.getNumChannels());
+    const auto totalChannels = juce::jmin(numChannels, numDelayChannels);
+    const auto blockStartClock = sampleClock;
+
+    // Linked pairs spawn one grain per pair of inputs; an odd last input stays mono.
+    const auto channelStep = stereoLink && totalChannels > 1 ? 2 : 1;
+    const auto grainsPerEvent = (totalChannels + channelStep - 1) / channelStep;
+
+    // Schedule the whole block up front: the smoothed delay tap for every frame, then
+    // the spawn events. Random draws happen in the same order as a per-sample loop
+    // would make them, so a given seed still produces the same grain cloud. Controls
+    // that are gliding take the per-sample path; settled ones the constant one.
+    smoothing.advance(numSamples);
     updateSpawnInterval(totalChannels);
 
-    smoothedDelaySamples.setTargetValue(millisecondsToSamples(delayMs, sampleRate));
-    const bool spawnEnabled = std::isfinite(spawnIntervalSamples) &&
-        spawnIntervalSamples < std::numeric_limits<float>::max();
+    if (smoothing.isRamping(smoothedDelay))
+        scheduleDelayTaps<true>(numSamples);
+    else
+        scheduleDelayTaps<false>(numSamples);
+
+    auto numSpawnEvents = smoothing.isRamping(smoothedDensity) ? scheduleSpawns<true>(numSamples, totalChannels)
+                                                               : scheduleSpawns<false>(numSamples, totalChannels);
+
+    // Thin the schedule while the governor is over budget. A skipped event drops the
+    // grain for every channel, so stereo pairs stay together.
+    size_t numKept = 0;
+    for (size_t event = 0; event < numSpawnEvents; ++event)
+    {
+        if (governor.shouldSpawn())
+            spawnFrames[numKept++] = spawnFrames[event];
+        else
+            for (int grain = 0; grain < grainsPerEvent; ++grain)
+                governor.grainDropped();
+    }
+    numSpawnEvents = numKept;
+
+    // Make room for this block's grains before spawning them, so the cloud never
+    // holds more sounding grains than the governor allows.
+    const auto newGrains = numSpawnEvents * static_cast<size_t>(grainsPerEvent);
+    const auto soundingGrains = activeGrainCount - releasingGrainCount;
+    const auto capacity = governor.getCapacity();
+    if (soundingGrains + newGrains > capacity)
+        stealGrains(soundingGrains + newGrains - capacity, windowTable);
+
+    if (numSpawnEvents > 0)
+    {
+        COSMIC_TRACE_SCOPE(tracer, "spawn burst");
+
+        for (size_t event = 0; event < numSpawnEvents; ++event)
+            for (int ch = 0; ch < totalChannels; ch += channelStep)
+                spawnGrain(ch, channelStep == 2 && ch + 1 < totalChannels ? ch + 1 : -1, blockStartClock + spawnFrames[event]);
+    }
+
+    // Feed the whole block into the delay line before any grain reads from it.
+    blockWritePosition = writePosition;
+    writeDelayBlock(buffer, startSample, numSamples, totalChannels);
 
-    for (int sample = 0; sample < numSamples; ++sample)
+    if (activeGrainCount > 0)
     {
-        const auto delayOffset = static_cast<int>(juce::roundToInt(smoothedDelaySamples.getNextValue()));
+        COSMIC_TRACE_SCOPE(tracer, "render grains");
+
+        std::fill_n(mix, static_cast<size_t>(numSamples) * mixStride, 0.0f);
+        selectGroupRenderers<SampleType>();
+
+        const auto renderedInParallel = parallelRendering && activeGrainCount >= parallelGrainThreshold
+                                     && renderGroupsInParallel(numSamples, windowTable);
+        if (!renderedInParallel)
+            for (size_t group = 0; group < activeGrainCount; group += laneWidth)
+                renderGroup(group, numSamples, windowTable, mix);
+
+        mixToOutputs(buffer, startSample, numSamples, juce::jmin(numChannels, panner.getNumChannels()));
+    }
 
-        if (spawnEnabled)
+    sampleClock += numSamples;
+    if (sampleClock >= nextReleaseSample)
+        releaseFinishedGrains();
+
+    writePosition = (writePosition + static_cast<size_t>(numSamples)) & static_cast<size_t>(delayMask);
+}
+
+template <bool ramping>
+void GrainEngine::scheduleDelayTaps(int numSamples) noexcept
+{
+    const auto delay = smoothing.get(smoothedDelay);
+    const auto start = static_cast<int>(writePosition);
+
+    for (int frame = 0; frame < numSamples; ++frame)
+        tapPositions[static_cast<size_t>(frame)] = (start + frame - juce::roundToInt(delay.at<ramping>(frame))) & delayMask;
+}
+
+template <bool ramping>
+size_t GrainEngine::scheduleSpawns(int numSamples, int numChannels) noexcept
+{
+    size_t numSpawnEvents = 0;
+
+    if constexpr (ramping)
+    {
+        const auto densityRamp = smoothing.get(smoothedDensity);
+        for (int frame = 0; frame < numSamples; ++frame)
         {
+            const auto interval = spawnIntervalFor(densityRamp.at<true>(frame), numChannels);
             spawnAccumulator += 1.0f;
-            while (spawnAccumulator >= spawnIntervalSamples)
+            while (spawnAccumulator >= interval && numSpawnEvents < spawnFrames.size())
             {
-                spawnAccumulator -= spawnIntervalSamples;
-                for (int ch = 0; ch < totalChannels; ++ch)
-                    spawnGrain(ch);
+                spawnAccumulator -= interval;
+                spawnFrames[numSpawnEvents++] = frame;
             }
         }
-        else
+        return numSpawnEvents;
+    }
+    else
+    {
+        const bool spawnEnabled = std::isfinite(spawnIntervalSamples) &&
+            spawnIntervalSamples < std::numeric_limits<float>::max();
+
+        if (!spawnEnabled)
         {
             spawnAccumulator = 0.0f;
+            return 0;
         }
 
-        for (int ch = 0; ch < totalChannels; ++ch)
+        // spawnIntervalSamples is at least one sample, so each frame fires at most once.
+        for (int frame = 0; frame < numSamples; ++frame)
         {
-            auto* channelData = channelWritePointers[ch];
-            auto* delayData = delayWritePointers[ch];
+            spawnAccumulator += 1.0f;
+            while (spawnAccumulator >= spawnIntervalSamples && numSpawnEvents < spawnFrames.size())
+            {
+                spawnAccumulator -= spawnIntervalSamples;
+                spawnFrames[numSpawnEvents++] = frame;
+            }
+        }
+        return numSpawnEvents;
+    }
+}
+
+template <typename SampleType>
+void GrainEngine::writeDelayBlock(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, int numChannels)
+{
+    // The block lands in the ring as at most two contiguous runs: up to the end of
+    // the ring, then the remainder from its start.
+    const auto firstRun = juce::jmin(numSamples, delayBufferSize - static_cast<int>(writePosition));
+
+    for (int ch = 0; ch < numChannels; ++ch)
+    {
+        const auto* input = buffer.getReadPointer(ch, startSample);
+        writeDelaySegment(ch, input, writePosition, 0, firstRun);
+        if (firstRun < numSamples)
+            writeDelaySegment(ch, input + firstRun, 0, firstRun, numSamples - firstRun);
+
+        buffer.clear(ch, startSample, numSamples);
+    }
+
+    updateDelayGuards<SampleType>();
+}
+
+template <typename SampleType>
+void GrainEngine::writeDelaySegment(int channel, const SampleType* input, size_t ringStart, int bufferOffset, int numSamples)
+{
+    // Each slot takes the feedback share of the sample written one delay length
+    // earlier, which may itself sit in two runs across the ring's end.
+    auto* history = getDelayLine<SampleType>().history.getWritePointer(channel, delayGuardSamples);
+    auto* ring = history + ringStart;
+    const auto source = (static_cast<int>(ringStart) - delayLength) & delayMask;
+    const auto firstRun = juce::jmin(numSamples, delayBufferSize - source);
+
+    juce::FloatVectorOperations::copy(ring, history + source, firstRun);
+    if (firstRun < numSamples)
+        juce::FloatVectorOperations::copy(ring + firstRun, history, numSamples - firstRun);
+    if (smoothing.isRamping(smoothedFeedback))
+        multiplyByRamp(ring, smoothing.get(smoothedFeedback).ramp + bufferOffset, numSamples);
+    else
+        juce::FloatVectorOperations::multiply(ring, static_cast<SampleType>(smoothing.getCurrent(smoothedFeedback)), numSamples);
+    juce::FloatVectorOperations::add(ring, input, numSamples);
+}
 
-            const auto drySample = channelData[sample];
-            channelData[sample] = 0.0f;
-            delayData[writePosition] = drySample + delayData[writePosition] * feedback;
+template <typename SampleType>
+void GrainEngine::updateDelayGuards()
+{
+    // Mirror the ring's ends into the guards: the front guard repeats the last
+    // samples of the ring and the back guard repeats the first ones.
+    auto& history = getDelayLine<SampleType>().history;
+    for (int ch = 0; ch < history.getNumChannels(); ++ch)
+    {
+        auto* data = history.getWritePointer(ch);
+        juce::FloatVectorOperations::copy(data, data + delayBufferSize, delayGuardSamples);
+        juce::FloatVectorOperations::copy(data + delayGuardSamples + delayBufferSize, data + delayGuardSamples, delayGuardSamples);
+    }
+}
+
+template <typename SampleType>
+void GrainEngine::selectGroupRenderers() noexcept
+{
+    // Buses of up to one register of outputs, stereo among them, keep the whole mix
+    // frame in a register; wider ones loop over their registers.
+    if (mixStride == laneWidth)
+        selectGroupRenderersFor<SampleType, 1>();
+    else
+        selectGroupRenderersFor<SampleType, 0>();
+}
+
+template <typename SampleType, size_t outputVectors>
+void GrainEngine::selectGroupRenderersFor() noexcept
+{
+    using Quality = GrainInterpolator::Quality;
+
+    switch (interpolation)
+    {
+        case Quality::linear:    selectGroupRenderersWith<SampleType, Quality::linear, outputVectors>(); break;
+        case Quality::hermite:   selectGroupRenderersWith<SampleType, Quality::hermite, outputVectors>(); break;
+        case Quality::lagrange6: selectGroupRenderersWith<SampleType, Quality::lagrange6, outputVectors>(); break;
+        case Quality::sinc:      selectGroupRenderersWith<SampleType, Quality::sinc, outputVectors>(); break;
+    }
+}
+
+template <typename SampleType, GrainInterpolator::Quality quality, size_t outputVectors>
+void GrainEngine::selectGroupRenderersWith() noexcept
+{
+    // A grain whose phase stays at zero reads whole samples, which every kernel but
+    // the sinc returns unchanged, so those qualities share one whole-step kernel. The
+    // sinc also lowpasses whole samples and keeps its full kernel.
+    constexpr auto exactOnSamples = quality != GrainInterpolator::Quality::sinc;
+    constexpr auto stepQuality = exactOnSamples ? GrainInterpolator::Quality::linear : quality;
+
+    groupRenderers = {
+        &GrainEngine::renderGroupWith<SampleType, quality, outputVectors, false, false, false>,
+        &GrainEngine::renderGroupWith<SampleType, quality, outputVectors, true, false, false>,
+        &GrainEngine::renderGroupWith<SampleType, quality, outputVectors, false, true, false>,
+        &GrainEngine::renderGroupWith<SampleType, quality, outputVectors, true, true, false>,
+        &GrainEngine::renderGroupWith<SampleType, stepQuality, outputVectors, false, false, exactOnSamples>,
+        &GrainEngine::renderGroupWith<SampleType, stepQuality, outputVectors, true, false, exactOnSamples>,
+        &GrainEngine::renderGroupWith<SampleType, stepQuality, outputVectors, false, true, exactOnSamples>,
+        &GrainEngine::renderGroupWith<SampleType, stepQuality, outputVectors, true, true, exactOnSamples>,
+    };
+}
+
+void GrainEngine::renderGroup(size_t group, int numFrames, const GrainWindowBank::Table& windowTable, float* mixFrames)
+{
+    // Everything the kernel would otherwise test per frame is settled here, once per
+    // group: where its grains sound, whether any reads a stereo pair, and whether all
+    // of them move by whole samples from a whole sample, so their phase never leaves
+    // zero. Parked lanes ride along and decide none of it.
+    const auto blockStartClock = sampleClock;
+    GroupSpan span;
+    span.start = numFrames;
+    span.end = 0;
+    bool coversBlock = true;
+    bool linked = false;
+    bool wholeSteps = true;
+
+    for (size_t l = 0; l < laneWidth; ++l)
+    {
+        const auto lane = group + l;
+        if (lane >= activeGrainCount)
+        {
+            span.firstFrame[l] = 0;
+            span.endFrame[l] = numFrames;
+            continue;
         }
 
-        size_t activeIndex = 0;
-        while (activeIndex < activeGrainCount)
+        span.firstFrame[l] = static_cast<int>(juce::jlimit<int64_t>(0, numFrames, lanes.startSample[lane] - blockStartClock));
+        span.endFrame[l] = static_cast<int>(juce::jlimit<int64_t>(0, numFrames, lanes.endSample[lane] - blockStartClock));
+        span.start = juce::jmin(span.start, span.firstFrame[l]);
+        span.end = juce::jmax(span.end, span.endFrame[l]);
+        coversBlock = coversBlock && span.firstFrame[l] == 0 && span.endFrame[l] == numFrames;
+        linked = linked || lanes.linked[lane];
+        wholeSteps = wholeSteps && lanes.phase[lane] == 0.0f && lanes.advance[lane] == std::trunc(lanes.advance[lane]);
+    }
+
+    if (span.start >= span.end)
+        return;
+
+    const auto variant = (linked ? linkedGroup : 0) | (coversBlock ? 0 : maskedGroup) | (wholeSteps ? wholeStepGroup : 0);
+    (this->*groupRenderers[variant])(group, windowTable, mixFrames, span);
+}
+
+template <typename SampleType, GrainInterpolator::Quality quality, size_t outputVectors, bool linked, bool masked, bool wholeSteps>
+void GrainEngine::renderGroupWith(size_t group, const GrainWindowBank::Table& windowTable, float* mixFrames,
+                                  const GroupSpan& span)
+{
+    // Renders one SIMD group of grains across its span of the block, keeping the
+    // grain state in registers from the first frame to the last. Masked groups hold
+    // each lane silent and still outside its own frames. Each frame's grain samples
+    // are added to every output at once, one register of outputs at a time; an
+    // outputVectors of 0 takes the count from the mix. Linked groups also read each
+    // lane's paired channel at the same positions; the mono lanes among them read
+    // their own channel twice and mix the copy at zero gain. Whole-step groups read
+    // one sample per lane and skip interpolation.
+    static_assert(!(wholeSteps && quality == GrainInterpolator::Quality::sinc),
+                  "The sinc kernel filters whole samples too");
+    constexpr auto numTaps = wholeSteps ? 1 : GrainInterpolator::numTaps(quality);
+    constexpr auto firstTap = wholeSteps ? 0 : GrainInterpolator::firstTap(quality);
+    static_assert(-firstTap <= delayGuardSamples && firstTap + numTaps - 1 <= delayGuardSamples,
+                  "Interpolation kernels must fit within the delay guard samples");
+
+    auto& delay = getDelayLine<SampleType>();
+    const auto* const* delayReadPointers = delay.history.getArrayOfReadPointers();
+    const auto blockWriteStart = static_cast<int>(blockWritePosition);
+    const auto wrapDistance = FloatVector::expand(static_cast<float>(delayLength));
+    const auto wrapForwardBelow = (delayLength + delayBufferSize) / 2;
+
+    alignas(64) float mask[laneWidth];
+    alignas(64) float offsets[laneWidth];
+    alignas(64) float envelopes[laneWidth];
+    alignas(64) float tapSamples[numTaps][laneWidth];
+    alignas(64) float pairedTapSamples[numTaps][laneWidth];
+    alignas(64) float fractions[laneWidth];
+    alignas(64) float windows[laneWidth];
+    alignas(64) float grainSamples[laneWidth];
+    alignas(64) float pairedSamples[laneWidth];
+    const auto* sincBands = lanes.sincBand.data() + group;
+    const SampleType* readData[laneWidth];
+    const SampleType* pairedReadData[laneWidth];
+
+    for (size_t l = 0; l < laneWidth; ++l)
+    {
+        const auto lane = group + l;
+        readData[l] = delayReadPointers[lanes.channel[lane]] + delayGuardSamples;
+        pairedReadData[l] = delayReadPointers[lanes.pairedChannel[lane]] + delayGuardSamples;
+    }
+
+    auto readOffset = FloatVector::fromRawArray(lanes.readOffset.data() + group);
+    auto phase = FloatVector::fromRawArray(lanes.phase.data() + group);
+    auto envelope = FloatVector::fromRawArray(lanes.envelope.data() + group);
+    const auto advance = FloatVector::fromRawArray(lanes.advance.data() + group);
+    const auto envelopeIncrement = FloatVector::fromRawArray(lanes.envelopeIncrement.data() + group);
+
+    // Parked lanes have no gains, so they are left out of the mix altogether.
+    const auto numLive = juce::jmin(laneWidth, activeGrainCount - group);
+    const auto numOutputVectors = outputVectors != 0 ? outputVectors : mixStride / laneWidth;
+    const float* gainRows[laneWidth];
+    const float* pairedGainRows[laneWidth];
+    for (size_t l = 0; l < laneWidth; ++l)
+    {
+        gainRows[l] = lanes.outputGains.data() + (group + l) * GrainPanner::maxChannels;
+        pairedGainRows[l] = lanes.pairedGains.data() + (group + l) * GrainPanner::maxChannels;
+    }
+
+    for (int frame = span.start; frame < span.end; ++frame)
+    {
+        const auto tap = tapPositions[static_cast<size_t>(frame)];
+        const auto writeHead = blockWriteStart + frame;
+
+        // Read heads wrap at the delay length, like the ring of exactly that length they
+        // stand in for: one that overtakes the write head drops a delay length back, and
+        // one left a delay length or more behind it moves a delay length forward.
+        const auto tapDelay = FloatVector::expand(static_cast<float>((writeHead - tap) & delayMask));
+        readOffset -= wrapDistance & FloatVector::greaterThan(readOffset, tapDelay);
+        readOffset += wrapDistance & FloatVector::lessThanOrEqual(readOffset, tapDelay - wrapDistance);
+        readOffset.copyToRawArray(offsets);
+        envelope.copyToRawArray(envelopes);
+
+        // A kernel's outer taps can still reach past the write head or a delay length
+        // behind it; those wrap the same way. Nothing is read from the slots this block
+        // writes after the current frame, so every read sees what a per-sample loop saw.
+        // The guard samples let the kernel run past either end of the ring unmasked.
+        const auto readDelay = [&](const SampleType* data, int index)
         {
-            auto poolIndex = activeIndices[activeIndex];
-            auto& grain = grainPool[poolIndex];
+            const auto behind = (writeHead - index) & delayMask;
+            if (behind < delayLength)
+                return static_cast<float>(data[index]);
 
-            if (!grain.active || grain.length == 0)
+            return static_cast<float>(data[(index + (behind < wrapForwardBelow ? delayLength : -delayLength)) & delayMask]);
+        };
+
+        // Whether any tap of a kernel starting at ring index first has to wrap.
+        const auto readsWrappedTap = [&](int first)
+        {
+            const auto behind = (writeHead - first) & delayMask;
+            return behind >= delayLength || behind < numTaps - 1;
+        };
+
+        for (size_t l = 0; l < laneWidth; ++l)
+        {
+            const auto first = ((tap + static_cast<int>(offsets[l])) & delayMask) + firstTap;
+
+            if (readsWrappedTap(first))
+            {
+                for (int k = 0; k < numTaps; ++k)
+                    tapSamples[k][l] = readDelay(readData[l], first + k);
+
+                if constexpr (linked)
+                    for (int k = 0; k < numTaps; ++k)
+                        pairedTapSamples[k][l] = readDelay(pairedReadData[l], first + k);
+            }
+            else
             {
-                releaseGrainAtActiveIndex(activeIndex);
-                continue;
+                const auto* source = readData[l] + first;
+                for (int k = 0; k < numTaps; ++k)
+                    tapSamples[k][l] = static_cast<float>(source[k]);
+
+                if constexpr (linked)
+                {
+                    const auto* pairedSource = pairedReadData[l] + first;
+                    for (int k = 0; k < numTaps; ++k)
+                        pairedTapSamples[k][l] = static_cast<float>(pairedSource[k]);
+                }
             }
 
-            auto* readData = delayBuffer.getReadPointer(grain.channel);
-            auto basePos = (static_cast<int>(writePosition) + delayBufferSize - delayOffset) % delayBufferSize;
-            auto readPos = (basePos - grain.startOffset + delayBufferSize) % delayBufferSize;
-            readPos = (readPos + static_cast<int>(grain.position)) % delayBufferSize;
+            windows[l] = GrainWindowBank::lookup(windowTable, envelopes[l]);
+        }
 
-            auto indexFloat = std::fmod(static_cast<float>(readPos) + grain.fractionalPosition,
-                                        static_cast<float>(delayBufferSize));
-            auto indexInt = static_cast<int>(std::floor(indexFloat));
-            auto frac = indexFloat - static_cast<float>(indexInt);
-            auto nextIndex = (indexInt + 1) % delayBufferSize;
+        if constexpr (quality == GrainInterpolator::Quality::sinc)
+            phase.copyToRawArray(fractions);
 
-            auto sampleA = readData[indexInt % delayBufferSize];
-            auto sampleB = readData[nextIndex];
-            auto window = getWindowValue(grain.envelope);
-            auto grainSample = juce::jmap(frac, sampleA, sampleB) * window;
+        const auto interpolate = [&](const float (&samples)[numTaps][laneWidth])
+        {
+            FloatVector taps[numTaps];
+            for (int k = 0; k < numTaps; ++k)
+                taps[k] = FloatVector::fromRawArray(samples[k]);
 
-            auto panLeft = std::cos(grain.pan * juce::MathConstants<float>::halfPi);
-            auto panRight = std::sin(grain.pan * juce::MathConstants<float>::halfPi);
+            if constexpr (wholeSteps)
+                return taps[0];
+            else if constexpr (quality == GrainInterpolator::Quality::linear)
+                return GrainInterpolator::linear(taps, phase);
+            else if constexpr (quality == GrainInterpolator::Quality::hermite)
+                return GrainInterpolator::hermite(taps, phase);
+            else if constexpr (quality == GrainInterpolator::Quality::lagrange6)
+                return GrainInterpolator::lagrange6(taps, phase);
+            else
+                return interpolator.sinc(taps, fractions, sincBands);
+        };
 
-            if (numChannels > 0)
-                channelWritePointers[0][sample] += grainSample * panLeft;
-            if (numChannels > 1)
-                channelWritePointers[1][sample] += grainSample * panRight;
+        const auto window = FloatVector::fromRawArray(windows);
+        auto grainSample = interpolate(tapSamples) * window;
+        FloatVector pairedSample;
+        if constexpr (linked)
+            pairedSample = interpolate(pairedTapSamples) * window;
 
-            grain.fractionalPosition += grain.rate;
-            grain.envelope += grain.envelopeIncrement;
-            grain.position += 1;
+        auto step = advance;
+        auto envelopeStep = envelopeIncrement;
+
+        if constexpr (masked)
+        {
+            for (size_t l = 0; l < laneWidth; ++l)
+                mask[l] = (frame >= span.firstFrame[l] && frame < span.endFrame[l]) ? 1.0f : 0.0f;
 
-            if (grain.position >= grain.length)
+            const auto active = FloatVector::fromRawArray(mask);
+            grainSample *= active;
+            if constexpr (linked)
+                pairedSample *= active;
+            step *= active;
+            envelopeStep *= active;
+        }
+
+        grainSample.copyToRawArray(grainSamples);
+        if constexpr (linked)
+            pairedSample.copyToRawArray(pairedSamples);
+
+        auto* frameMix = mixFrames + static_cast<size_t>(frame) * mixStride;
+        for (size_t v = 0; v < numOutputVectors; ++v)
+        {
+            auto outputs = FloatVector::fromRawArray(frameMix + v * laneWidth);
+            for (size_t l = 0; l < numLive; ++l)
             {
-                releaseGrainAtActiveIndex(activeIndex);
-                continue;
+                outputs += FloatVector::expand(grainSamples[l]) * FloatVector::fromRawArray(gainRows[l] + v * laneWidth);
+                if constexpr (linked)
+                    outputs += FloatVector::expand(pairedSamples[l]) * FloatVector::fromRawArray(pairedGainRows[l] + v * laneWidth);
             }
-
-            ++activeIndex;
+            outputs.copyToRawArray(frameMix + v * laneWidth);
         }
 
-        writePosition = (writePosition + 1) % static_cast<size_t>(delayBufferSize);
+        envelope += envelopeStep;
+
+        // Carry whole samples out of the fractional phase so it stays in 0-1 and
+        // keeps full interpolation precision however long the grain runs. Whole
+        // steps leave the phase at zero.
+        if constexpr (wholeSteps)
+        {
+            readOffset += step;
+        }
+        else
+        {
+            phase += step;
+            const auto whole = FloatVector::truncate(phase);
+            phase -= whole;
+            readOffset += whole;
+        }
     }
 
-    updateVisualSnapshot();
+    readOffset.copyToRawArray(lanes.readOffset.data() + group);
+    phase.copyToRawArray(lanes.phase.data() + group);
+    envelope.copyToRawArray(lanes.envelope.data() + group);
 }
 
-void GrainEngine::spawnGrain(int channel)
+bool GrainEngine::renderGroupsInParallel(int numFrames, const GrainWindowBank::Table& windowTable)
 {
-    if (channel < 0 || channel >= delayBuffer.getNumChannels())
+    // A block that finds the pool being swapped renders on its own rather than wait.
+    const juce::SpinLock::ScopedTryLockType lock(renderPoolLock);
+    if (!lock.isLocked() || renderPool == nullptr)
+        return false;
+
+    pendingWindow = &windowTable;
+    pendingFrames = numFrames;
+
+    const auto numChunks = static_cast<int>((activeGrainCount + grainsPerChunk - 1) / grainsPerChunk);
+    renderPool->run(*this, numChunks);
+
+    const auto mixSize = static_cast<size_t>(numFrames) * mixStride;
+    const auto chunkMixSize = static_cast<size_t>(maxBlockSize) * mixStride;
+    for (int chunk = 0; chunk < numChunks; ++chunk)
+        juce::FloatVectorOperations::add(mix, chunkMixes + static_cast<size_t>(chunk) * chunkMixSize, static_cast<int>(mixSize));
+    return true;
+}
+
+void GrainEngine::renderChunk(int chunkIndex) noexcept
+{
+    auto* chunkMix = chunkMixes + static_cast<size_t>(chunkIndex) * static_cast<size_t>(maxBlockSize) * mixStride;
+    std::fill_n(chunkMix, static_cast<size_t>(pendingFrames) * mixStride, 0.0f);
+
+    const auto firstGrain = static_cast<size_t>(chunkIndex) * grainsPerChunk;
+    const auto endGrain = juce::jmin(firstGrain + grainsPerChunk, activeGrainCount);
+
+    for (auto group = firstGrain; group < endGrain; group += laneWidth)
+        renderGroup(group, pendingFrames, *pendingWindow, chunkMix);
+}
+
+template <typename SampleType>
+void GrainEngine::mixToOutputs(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, int numOutputs) noexcept
+{
+    for (int channel = 0; channel < numOutputs; ++channel)
+    {
+        auto* output = buffer.getWritePointer(channel, startSample);
+        const auto* source = mix + channel;
+
+        for (int frame = 0; frame < numSamples; ++frame)
+            output[frame] += source[static_cast<size_t>(frame) * mixStride];
+    }
+}
+
+void GrainEngine::spawnGrain(int channel, int pairedChannel, int64_t startSample)
+{
+    if (channel < 0 || channel >= numDelayChannels)
         return;
 
-    size_t poolIndex = 0;
-    if (auto* grain = allocateGrain(poolIndex))
+    if (pairedChannel >= numDelayChannels)
+        pairedChannel = -1;
+
+    size_t lane = 0;
+    if (!allocateGrain(lane))
     {
-        // Initialise the grain directly inside the pool slot to avoid moves.
-        grain->channel = channel;
-        grain->position = 0;
-
-        const auto lengthMs = juce::jmax(10.0f, grainSizeMs + (randomDist(rng) - 0.5f) * spreadMs);
-        grain->length = static_cast<size_t>(millisecondsToSamples(lengthMs, sampleRate));
-        grain->length = std::max<std::size_t>(static_cast<std::size_t>(32), grain->length);
-
-        const auto jitterAmount = (randomDist(rng) - 0.5f) * pitchJitter;
-        grain->rate = semitoneToRate(pitch + jitterAmount);
-        grain->envelope = 0.0f;
-        grain->envelopeIncrement = 1.0f / static_cast<float>(grain->length);
-        grain->fractionalPosition = 0.0f;
-        grain->pan = juce::jlimit(0.0f, 1.0f, randomDist(rng));
-        grain->startOffset = scatterSamples > 0 ? static_cast<int>(randomDist(rng) * static_cast<float>(scatterSamples)) : 0;
-        grain->active = true;
+        governor.grainDropped();
+        return;
     }
+
+    governor.grainSpawned();
+
+    // Each grain takes the controls as they stood at its spawn frame.
+    const auto frame = static_cast<int>(startSample - sampleClock);
+    const auto grainPitch = smoothing.get(smoothedPitch).at(frame);
+    const auto scatterSamples = static_cast<size_t>(juce::roundToInt(
+        std::min(millisecondsToSamples(smoothing.get(smoothedScatter).at(frame), sampleRate), static_cast<float>(delayLength))));
+
+    const auto lengthMs = juce::jmax(10.0f, smoothing.get(smoothedGrainSize).at(frame)
+                                                + (randomDist(rng) - 0.5f) * smoothing.get(smoothedSpread).at(frame));
+    auto length = static_cast<int64_t>(millisecondsToSamples(lengthMs, sampleRate));
+    length = std::max<int64_t>(32, length);
+
+    const auto jitterAmount = (randomDist(rng) - 0.5f) * smoothing.get(smoothedPitchJitter).at(frame);
+    const auto rate = semitoneToRate(grainPitch + jitterAmount);
+    const auto pan = juce::jlimit(0.0f, 1.0f, randomDist(rng));
+    const auto startOffset = scatterSamples > 0 ? static_cast<int>(randomDist(rng) * static_cast<float>(scatterSamples)) : 0;
+
+    // The read head follows the moving delay tap and additionally advances by the
+    // playback rate, so it moves 1 + rate samples per output sample.
+    lanes.readOffset[lane] = static_cast<float>(-startOffset);
+    lanes.phase[lane] = 0.0f;
+    lanes.advance[lane] = 1.0f + rate;
+    lanes.envelope[lane] = 0.0f;
+    lanes.envelopeIncrement[lane] = 1.0f / static_cast<float>(length);
+    auto* gains = lanes.outputGains.data() + lane * GrainPanner::maxChannels;
+    auto* pairedGains = lanes.pairedGains.data() + lane * GrainPanner::maxChannels;
+    if (pairedChannel >= 0)
+        panner.getPairGains(pan, gains, pairedGains);
+    else
+        panner.getGains(pan, gains);
+    lanes.loudestGain[lane] = 0.0f;
+    for (int output = 0; output < panner.getNumChannels(); ++output)
+        lanes.loudestGain[lane] = juce::jmax(lanes.loudestGain[lane], std::abs(gains[output]), std::abs(pairedGains[output]));
+    lanes.channel[lane] = channel;
+    lanes.pairedChannel[lane] = pairedChannel >= 0 ? pairedChannel : channel;
+    lanes.linked[lane] = pairedChannel >= 0;
+    lanes.startSample[lane] = startSample;
+    lanes.endSample[lane] = startSample + length;
+    lanes.pitchSemitone[lane] = grainPitch + jitterAmount;
+    lanes.pan[lane] = pan;
+    lanes.sincBand[lane] = GrainInterpolator::sincBandForSpeed(1.0f + lanes.advance[lane]);
+
+    nextReleaseSample = std::min(nextReleaseSample, lanes.endSample[lane]);
 }
 
 void GrainEngine::updateVisualSnapshot()
 {
-    auto nextIndex = 1 - visualSnapshotIndex.load(std::memory_order_relaxed);
-    auto& snapshot = visualSnapshots[nextIndex];
-    snapshot.grainCount = 0;
+    if (!telemetryEnabled.load(std::memory_order_relaxed))
+        return;
+
+    auto& snapshot = visualSnapshots.getWriteBuffer();
     snapshot.activeGrains = activeGrainCount;
     snapshot.spawnRatePerSecond = (spawnIntervalSamples > 0.0f && std::isfinite(spawnIntervalSamples))
         ? static_cast<float>(sampleRate) / spawnIntervalSamples
         : 0.0f;
     snapshot.delayTimeMs = delayMs;
+    snapshot.grainCapacity = governor.getCapacity();
+    snapshot.cpuLoad = governor.getLoad();
+
+    const auto counters = governor.getCounters();
+    snapshot.grainsStolen = counters.stolen;
+    snapshot.grainsDropped = counters.dropped;
 
     const size_t limit = juce::jmin(activeGrainCount, snapshot.grains.size());
     size_t outIndex = 0;
 
-    for (size_t i = 0; i < activeGrainCount && outIndex < limit; ++i)
+    for (size_t lane = 0; lane < limit; ++lane)
     {
-        auto poolIndex = activeIndices[i];
-        const auto& grain = grainPool[poolIndex];
-
-        if (!grain.active || grain.length == 0)
+        const auto length = lanes.endSample[lane] - lanes.startSample[lane];
+        if (length <= 0)
             continue;
 
+        const auto position = sampleClock - lanes.startSample[lane];
         auto& visual = snapshot.grains[outIndex++];
-        visual.pan = grain.pan;
-        visual.age = grain.length > 0 ? juce::jlimit(0.0f, 1.0f, static_cast<float>(grain.position) / static_cast<float>(grain.length)) : 0.0f;
-        visual.durationSeconds = static_cast<float>(grain.length) / static_cast<float>(sampleRate);
-        visual.pitchSemitone = static_cast<float>(std::log2(juce::jmax(0.0001f, grain.rate)) * 12.0f);
-        visual.envelope = juce::jlimit(0.0f, 1.0f, grain.envelope);
+        visual.pan = lanes.pan[lane];
+        visual.age = juce::jlimit(0.0f, 1.0f, static_cast<float>(position) / static_cast<float>(length));
+        visual.durationSeconds = static_cast<float>(length) / static_cast<float>(sampleRate);
+        visual.pitchSemitone = lanes.pitchSemitone[lane];
+        visual.envelope = juce::jlimit(0.0f, 1.0f, lanes.envelope[lane]);
     }
 
     snapshot.grainCount = outIndex;
-    visualSnapshotIndex.store(nextIndex, std::memory_order_release);
+    visualSnapshots.publish();
 }
 
-GrainEngine::VisualSnapshot GrainEngine::getVisualSnapshot() const
+size_t GrainEngine::getMemoryBytes() const noexcept
 {
-    auto index = visualSnapshotIndex.load(std::memory_order_acquire);
-    return visualSnapshots[index];
+    const auto bufferBytes = [](const auto& buffer)
+    {
+        return static_cast<size_t>(buffer.getNumChannels()) * static_cast<size_t>(buffer.getNumSamples()) * sizeof(*buffer.getReadPointer(0));
+    };
+
+    return sizeof(*this) + bufferBytes(floatDelay.history) + bufferBytes(doubleDelay.history)
+         + (mixStorage.capacity() + chunkMixStorage.capacity()) * sizeof(float)
+         + (tapPositions.capacity() + spawnFrames.capacity()) * sizeof(int);
 }
 
-float GrainEngine::getWindowValue(float env) const
+const GrainEngine::VisualSnapshot& GrainEngine::acquireVisualSnapshot() noexcept
 {
-    auto t = juce::jlimit(0.0f, 1.0f, env);
-    // Clamp the window to avoid tiny negative values from sin() that would turn into NaNs when pow() is fed a fractional exponent.
-    auto base = juce::jlimit(0.0f, 1.0f, std::sin(t * juce::MathConstants<float>::pi));
-    if (base <= 0.0f)
-        return 0.0f;
-    auto exponent = juce::jmap(envelopeShape, 0.0f, 1.0f, 0.5f, 4.0f);
-    return std::pow(base, exponent);
+    visualSnapshots.acquireLatest();
+    return visualSnapshots.getReadBuffer();
 }
+
+template void GrainEngine::processBlock(juce::AudioBuffer<float>&);
+template void GrainEngine::processBlock(juce::AudioBuffer<double>&);
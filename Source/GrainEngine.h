@@ -4,15 +4,38 @@
 #include <array>
 #include <atomic>
 #include <cstdint>
+#include <limits>
+#include <memory>
 #include <random>
+#include <type_traits>
+#include <vector>
 
-class GrainEngine
+#include "GrainGovernor.h"
+#include "GrainInterpolator.h"
+#include "GrainPanner.h"
+#include "GrainRenderPool.h"
+#include "GrainWindowBank.h"
+#include "SmoothingBank.h"
+#include "TraceRecorder.h"
+#include "TripleBuffer.h"
+
+class GrainEngine : private GrainRenderPool::Client
 {
 public:
     GrainEngine();
+    ~GrainEngine() override;
 
-    void prepare(const juce::dsp::ProcessSpec& spec);
+    // Every input channel (spec.numChannels) feeds grains of its own, which the panner
+    // spreads over the output layout. Without a layout the outputs match the inputs.
+    // The engine's buffer carries the inputs first, with the remaining outputs silent.
+    // The delay line holds samples in the precision processBlock() will be called
+    // with; grains read it and render in single precision either way.
+    void prepare(const juce::dsp::ProcessSpec& spec, const juce::AudioChannelSet& outputLayout = {},
+                 bool useDoublePrecision = false);
     void reset();
+    // Audio thread: silences the delay line and drops every grain. Unlike reset() it
+    // never rebuilds window tables.
+    void clear();
 
     void setGrainSize(float milliseconds);
     void setDensity(float grainsPerSecond);
@@ -23,13 +46,79 @@ public:
     void setDelayTime(float milliseconds);
     void setScatter(float milliseconds);
     void setEnvelopeShape(float shape);
+    void setWindowShape(GrainWindowBank::Shape shape);
     void setPitchJitter(float semitones);
+    // Audio thread: the fractional delay reader used by every grain from the next block.
+    void setInterpolation(GrainInterpolator::Quality quality) noexcept { interpolation = quality; }
+    // Audio thread: whether spawn events from the next block play each pair of inputs
+    // (1+2, 3+4, ...) as one stereo grain instead of a mono grain per input. A linked
+    // grain reads both delay channels with one envelope, phase and pitch and places
+    // the pair with its width intact, rotated round its pan position. The spawn rate
+    // is unchanged, so a stereo cloud renders half the grains. Sounding grains keep
+    // their type.
+    void setStereoLink(bool shouldLinkPairs) noexcept { stereoLink = shouldLinkPairs; }
+    // Message thread, before processing: restarts the random draws behind grain
+    // lengths, pitches, pans and scatter, so a given seed spawns the same cloud.
+    void setRandomSeed(uint32_t seed)
+    {
+        rng.seed(seed);
+        randomDist.reset();
+    }
+
+   #if COSMIC_ENABLE_TRACING
+    // Message thread, while processBlock() is not running. Null stops tracing.
+    void setTraceRecorder(TraceRecorder* recorder) noexcept { tracer = recorder; }
+   #endif
+
+    // Audio thread: float or double, matching what prepare() was told.
+    template <typename SampleType>
+    void processBlock(juce::AudioBuffer<SampleType>& buffer);
+
+    // Optional multi-core rendering for very dense clouds. setRenderThreads() starts
+    // or stops the worker pool from the message thread after prepare(), and may run
+    // while processBlock() does: blocks render on the calling thread until the new
+    // pool is in place. setParallelRendering() is safe on the audio thread.
+    // Below parallelGrainThreshold grains the block is always rendered on the
+    // calling thread, as waking workers would cost more than it saves.
+    void setRenderThreads(int numWorkers);
+    void setParallelRendering(bool shouldRenderInParallel) noexcept { parallelRendering = shouldRenderInParallel; }
+    void setAudioWorkgroup(const juce::AudioWorkgroup& workgroupToJoin);
+    int getNumRenderThreads() const noexcept { return renderPool != nullptr ? renderPool->getNumWorkers() : 0; }
+
+    static constexpr size_t parallelGrainThreshold = 192;
+
+    size_t getActiveGrainCount() const noexcept { return activeGrainCount; }
+    const GrainPanner& getPanner() const noexcept { return panner; }
+
+    // Audio thread: estimates for the current settings. The peak gain is the most the
+    // cloud can amplify its input, from how many grains can overlap. The typical gain
+    // is the level it settles at for noise-like input, whose overlapping grains add in
+    // power: the square root of their summed window energy, and at least one grain's
+    // unity peak. The tail is how long output can stay above the threshold once the
+    // cloud has reached the given level.
+    float getPeakGain() const noexcept;
+    float getTypicalGain() const noexcept;
+    double getTailSeconds(float level, float threshold) const noexcept;
+
+    // The engine with the buffers prepare() sized, not counting render worker threads.
+    size_t getMemoryBytes() const noexcept;
 
-    void processBlock(juce::AudioBuffer<float>& buffer);
+    // CPU-budget governor. Configure it from the audio thread (budget, steal policy,
+    // enable); its counters and load estimate may be read from any thread. When the
+    // governor lowers the grain capacity the engine steals grains down to it, fading
+    // each victim out over a few milliseconds instead of cutting it.
+    GrainGovernor& getGovernor() noexcept { return governor; }
+    const GrainGovernor& getGovernor() const noexcept { return governor; }
+
+    // Window tables are rebuilt by whoever services this client (the processor's
+    // background thread). Without one, prepare() and reset() still rebuild them.
+    GrainWindowBank& getWindowBank() noexcept { return windowBank; }
+    const GrainWindowBank& getWindowBank() const noexcept { return windowBank; }
 
     // Telemetry structures mirrored to the editor so it can render a live particle view
-    // without touching the real-time grain pool directly. The audio thread populates a
-    // double-buffered snapshot once per block, and the GUI polls using getVisualSnapshot().
+    // without touching the real-time grain pool directly. While telemetry is enabled the
+    // audio thread publishes a snapshot through a triple buffer once per block; while it
+    // is off the engine does no telemetry work at all.
     struct VisualGrain
     {
         float pan = 0.5f;           // 0 = hard left, 1 = hard right
@@ -46,44 +135,205 @@ public:
         size_t activeGrains = 0;
         float spawnRatePerSecond = 0.0f;
         float delayTimeMs = 0.0f;
+        size_t grainCapacity = 0;
+        float cpuLoad = 0.0f;        // governor's smoothed share of its budget
+        uint64_t grainsStolen = 0;
+        uint64_t grainsDropped = 0;
     };
 
-    VisualSnapshot getVisualSnapshot() const;
+    // Any thread: the editor turns telemetry on while it is open.
+    void setTelemetryEnabled(bool shouldBeEnabled) noexcept { telemetryEnabled.store(shouldBeEnabled, std::memory_order_relaxed); }
+
+    // Single reader: swaps in the newest published snapshot, which stays valid and
+    // unchanged until the reader's next call.
+    const VisualSnapshot& acquireVisualSnapshot() noexcept;
 
 private:
-    struct Grain
+    using FloatVector = juce::dsp::SIMDRegister<float>;
+
+    static constexpr size_t maxGrains = 1024;
+    static constexpr size_t laneWidth = FloatVector::SIMDNumElements;
+    static_assert(maxGrains % laneWidth == 0, "Grain pool must hold a whole number of SIMD groups");
+
+    // Lanes kept free above the governor's capacity so stolen grains have room to
+    // fade out while their replacements start.
+    static constexpr size_t stealHeadroom = 64;
+    static constexpr size_t nominalGrainCapacity = maxGrains - stealHeadroom;
+
+    // Parallel work unit. A chunk spans whole cache lines of every lane array, so
+    // threads rendering neighbouring chunks never write to the same line.
+    static constexpr size_t grainsPerChunk = 64;
+    static constexpr size_t maxRenderChunks = maxGrains / grainsPerChunk;
+    static_assert(grainsPerChunk % laneWidth == 0 && maxGrains % grainsPerChunk == 0,
+                  "Render chunks must hold whole SIMD groups and tile the pool");
+
+    // Structure-of-arrays grain pool. Active grains are packed into lanes
+    // [0, activeGrainCount) so the render kernel can walk them one SIMD group at a
+    // time. Releasing a grain moves the last active lane into the freed slot and
+    // zeroes the vacated lane, so a partially filled trailing group renders silence.
+    struct GrainLanes
     {
-        int channel = 0;
-        size_t position = 0;
-        size_t length = 0;
-        float rate = 1.0f;
-        float envelope = 0.0f;
-        float envelopeIncrement = 0.0f;
-        float fractionalPosition = 0.0f;
-        float pan = 0.5f;
-        int startOffset = 0;
-        bool active = false;
+        alignas(64) std::array<float, maxGrains> readOffset {};   // whole samples past the grain's delay tap
+        alignas(64) std::array<float, maxGrains> phase {};        // fractional read position, 0-1
+        alignas(64) std::array<float, maxGrains> advance {};      // read-head movement per output sample
+        alignas(64) std::array<float, maxGrains> envelope {};
+        alignas(64) std::array<float, maxGrains> envelopeIncrement {};
+        alignas(64) std::array<float, maxGrains * GrainPanner::maxChannels> outputGains {}; // one row per grain, fixed at spawn
+        alignas(64) std::array<float, maxGrains * GrainPanner::maxChannels> pairedGains {}; // zero unless linked
+        std::array<float, maxGrains> loudestGain {};
+        std::array<int, maxGrains> channel {};
+        std::array<int, maxGrains> pairedChannel {}; // the right-hand input of a linked grain, else channel
+        std::array<bool, maxGrains> linked {};
+        std::array<int64_t, maxGrains> startSample {};
+        std::array<int64_t, maxGrains> endSample {};
+        std::array<float, maxGrains> pitchSemitone {}; // for telemetry, fixed at spawn
+        std::array<float, maxGrains> pan {};
+        std::array<bool, maxGrains> releasing {}; // stolen and fading out
+        std::array<int, maxGrains> sincBand {};   // GrainInterpolator band for the grain's read speed
     };
 
-    static constexpr size_t maxGrains = 1024;
+    // Delay history in one sample type. Only the one for the prepared precision holds
+    // any storage.
+    template <typename SampleType>
+    struct DelayLine
+    {
+        // A power-of-two ring, indexed with delayMask. Each channel holds
+        // delayGuardSamples mirrored samples on either side of the ring, so an
+        // interpolator can read a few neighbours of any ring index without wrapping;
+        // ring index 0 lives at sample delayGuardSamples of the buffer.
+        juce::AudioBuffer<SampleType> history;
+    };
+
+    template <typename SampleType>
+    DelayLine<SampleType>& getDelayLine() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleDelay;
+        else
+            return floatDelay;
+    }
+
+    // The frames of the block each lane of a group sounds in, and their union.
+    struct GroupSpan
+    {
+        int firstFrame[laneWidth];
+        int endFrame[laneWidth];
+        int start = 0;
+        int end = 0;
+    };
+
+    // Render kernels are compiled for every combination of the settings that hold
+    // for a whole block, so the per-frame loop tests none of them. Once per block
+    // selectGroupRenderers() fills one kernel per group variant for the current
+    // precision, interpolation and output count; renderGroup() then picks a group's
+    // variant from these bits.
+    static constexpr size_t linkedGroup = 1;    // some lane reads a stereo pair
+    static constexpr size_t maskedGroup = 2;    // some lane starts or ends inside the block
+    static constexpr size_t wholeStepGroup = 4; // every lane reads whole samples, e.g. at unity pitch
+    static constexpr size_t numGroupVariants = 8;
+    using GroupRenderer = void (GrainEngine::*)(size_t, const GrainWindowBank::Table&, float*, const GroupSpan&);
 
     void resetPool();
-    Grain* allocateGrain(size_t& indexOut);
-    void releaseGrainAtActiveIndex(size_t activeListIndex);
+    void clearDelayLines();
+    template <typename SampleType>
+    void writeDelayBlock(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, int numChannels);
+    template <typename SampleType>
+    void writeDelaySegment(int channel, const SampleType* input, size_t ringStart, int bufferOffset, int numSamples);
+    template <typename SampleType>
+    void updateDelayGuards();
+    bool allocateGrain(size_t& laneOut);
+    void releaseLane(size_t lane);
+    void releaseFinishedGrains();
+    void stealGrains(size_t count, const GrainWindowBank::Table& windowTable);
+    void beginSteal(size_t lane, const GrainWindowBank::Table& windowTable);
+    template <typename SampleType>
+    void processChunk(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples,
+                      const GrainWindowBank::Table& windowTable);
+    template <typename SampleType>
+    void selectGroupRenderers() noexcept;
+    template <typename SampleType, size_t outputVectors>
+    void selectGroupRenderersFor() noexcept;
+    template <typename SampleType, GrainInterpolator::Quality quality, size_t outputVectors>
+    void selectGroupRenderersWith() noexcept;
+    void renderGroup(size_t group, int numFrames, const GrainWindowBank::Table& windowTable, float* mixFrames);
+    template <typename SampleType, GrainInterpolator::Quality quality, size_t outputVectors, bool linked, bool masked, bool wholeSteps>
+    void renderGroupWith(size_t group, const GrainWindowBank::Table& windowTable, float* mixFrames,
+                         const GroupSpan& span);
+    // False when the block must render on the calling thread instead.
+    bool renderGroupsInParallel(int numFrames, const GrainWindowBank::Table& windowTable);
+    void prepareMixes();
+    size_t getMixSize() const noexcept;
+    template <typename SampleType>
+    void mixToOutputs(juce::AudioBuffer<SampleType>& buffer, int startSample, int numSamples, int numOutputs) noexcept;
+    void renderChunk(int chunkIndex) noexcept override;
     void updateSpawnInterval(int numChannels);
+    float spawnIntervalFor(float grainsPerSecond, int numChannels) const noexcept;
+    void snapSmoothedParameters() noexcept;
+    template <bool ramping>
+    void scheduleDelayTaps(int numSamples) noexcept;
+    template <bool ramping>
+    size_t scheduleSpawns(int numSamples, int numChannels) noexcept;
     void updateVisualSnapshot();
-    void spawnGrain(int channel);
-    float getWindowValue(float env) const;
+    // A negative pairedChannel spawns a mono grain.
+    void spawnGrain(int channel, int pairedChannel, int64_t startSample);
 
     std::mt19937 rng { std::random_device{}() };
     std::uniform_real_distribution<float> randomDist { 0.0f, 1.0f };
 
-    std::array<Grain, maxGrains> grainPool {};
-    std::array<uint16_t, maxGrains> activeIndices {};
-    std::array<uint16_t, maxGrains> freeIndices {};
+    GrainLanes lanes;
     size_t activeGrainCount = 0;
-    size_t freeGrainCount = maxGrains;
-    juce::AudioBuffer<float> delayBuffer;
+    size_t releasingGrainCount = 0;
+    int64_t sampleClock = 0;
+    int64_t nextReleaseSample = std::numeric_limits<int64_t>::max();
+    static constexpr int delayGuardSamples = juce::jmax(GrainInterpolator::maxTapsBefore, GrainInterpolator::maxTapsAfter);
+    DelayLine<float> floatDelay;
+    DelayLine<double> doubleDelay;
+    bool doublePrecision = false;
+    int numDelayChannels = 0;
+    int delayBufferSize = 0;
+    int delayMask = 0;
+    // The delay line's length in samples, two seconds. Feedback comes round and reads
+    // wrap after exactly this long, whatever power of two holds the ring; the slots
+    // further back give a block's feedback and a kernel's outer taps room to read.
+    int delayLength = 0;
+
+    // Per-block schedule, sized in prepare(): the delay tap for every frame and the
+    // frames at which the spawn accumulator fires.
+    std::vector<int> tapPositions;
+    size_t blockWritePosition = 0;
+
+    // Swapped by setRenderThreads() under renderPoolLock, which the audio thread only
+    // ever try-locks, together with the chunk mixes.
+    std::unique_ptr<GrainRenderPool> renderPool;
+    juce::SpinLock renderPoolLock;
+    juce::AudioWorkgroup audioWorkgroup;
+    bool parallelRendering = false;
+    const GrainWindowBank::Table* pendingWindow = nullptr;
+    int pendingFrames = 0;
+    std::array<GroupRenderer, numGroupVariants> groupRenderers {};
+
+    // Grains accumulate into a frame-interleaved mix that holds every output, padded
+    // to whole SIMD registers, so the kernel adds a grain to all outputs a register at
+    // a time. The mix is spread onto the output channels once per block. Render
+    // chunks get one mix each rather than one per worker, so the final sum runs in
+    // chunk order and the output does not depend on which thread took which chunk.
+    GrainPanner panner;
+    size_t mixStride = laneWidth; // floats per frame
+    std::vector<float> mixStorage;
+    std::vector<float> chunkMixStorage;
+    float* mix = nullptr;
+    float* chunkMixes = nullptr;
+    std::vector<int> spawnFrames;
+    int maxBlockSize = 0;
+
+   #if COSMIC_ENABLE_TRACING
+    TraceRecorder* tracer = nullptr;
+   #endif
+
+    GrainGovernor governor;
+    // Victim selection scratch, so stealing never allocates.
+    std::array<float, maxGrains> stealScores {};
+    std::array<uint16_t, maxGrains> stealCandidates {};
 
     double sampleRate = 44100.0;
     size_t writePosition = 0;
@@ -95,11 +345,39 @@ private:
     float delayMs = 400.0f;
     float spawnAccumulator = 0.0f;
     float scatterMs = 20.0f;
-    size_t scatterSamples = 0;
     float envelopeShape = 0.5f;
+    GrainWindowBank::Shape windowShape = GrainWindowBank::Shape::sineArc;
+    GrainWindowBank windowBank;
+    float windowEnergy = 0.5f; // meanSquare of the table the last block read
     float pitchJitter = 0.0f;
+    GrainInterpolator interpolator;
+    GrainInterpolator::Quality interpolation = GrainInterpolator::Quality::linear;
+    bool stereoLink = false;
     float spawnIntervalSamples = 1.0f;
-    juce::LinearSmoothedValue<float> smoothedDelaySamples;
-    VisualSnapshot visualSnapshots[2] {};
-    std::atomic<int> visualSnapshotIndex { 0 };
+    // The density and channel count spawnIntervalSamples was derived from; a negative
+    // density forces the next block to derive it again.
+    float spawnIntervalDensity = -1.0f;
+    int spawnIntervalChannels = 0;
+
+    // The fields above hold each control's target, which the tail and peak estimates
+    // use; what the audio hears glides towards them per sample. Delay is in samples.
+    enum SmoothedParameter : size_t
+    {
+        smoothedGrainSize,
+        smoothedDensity,
+        smoothedPitch,
+        smoothedSpread,
+        smoothedScatter,
+        smoothedPitchJitter,
+        smoothedFeedback,
+        smoothedDelay,
+        numSmoothedParameters
+    };
+
+    SmoothingBank<numSmoothedParameters> smoothing;
+
+    // Kept off the cache lines of the grain pool and render state; the triple buffer
+    // separates its own indices.
+    alignas(64) TripleBuffer<VisualSnapshot> visualSnapshots;
+    alignas(64) std::atomic<bool> telemetryEnabled { false };
 };
@@ -0,0 +1,98 @@
+#include "GrainGovernor.h"
+
+namespace
+{
+// The load estimate rises quickly so a sudden overload is caught within a few
+// blocks, and falls slowly so one lucky block does not undo the throttling.
+constexpr float loadAttack = 0.3f;
+constexpr float loadRelease = 0.05f;
+
+// Below this share of the budget the governor hands capacity back.
+constexpr float recoveryLoad = 0.75f;
+}
+
+void GrainGovernor::prepare(double newSampleRate, size_t capacityToUse)
+{
+    sampleRate = newSampleRate;
+    nominalCapacity = capacityToUse;
+    capacity = nominalCapacity;
+    smoothedLoad = 0.0f;
+    spawnKeep = 1.0f;
+    keepAccumulator = 0.0f;
+
+    publishedLoad.store(0.0f, std::memory_order_relaxed);
+    publishedCapacity.store(capacity, std::memory_order_relaxed);
+}
+
+void GrainGovernor::setEnabled(bool shouldBeEnabled) noexcept
+{
+    if (enabled == shouldBeEnabled)
+        return;
+
+    enabled = shouldBeEnabled;
+    if (!enabled)
+    {
+        capacity = nominalCapacity;
+        spawnKeep = 1.0f;
+        smoothedLoad = 0.0f;
+        publishedCapacity.store(capacity, std::memory_order_relaxed);
+    }
+}
+
+void GrainGovernor::blockFinished(int numSamples, size_t liveGrains) noexcept
+{
+    if (numSamples <= 0 || sampleRate <= 0.0)
+        return;
+
+    const auto elapsed = juce::Time::highResolutionTicksToSeconds(juce::Time::getHighResolutionTicks() - blockStartTicks);
+    const auto allowed = static_cast<double>(numSamples) / sampleRate * static_cast<double>(budget);
+    const auto load = static_cast<float>(elapsed / allowed);
+
+    smoothedLoad += (load - smoothedLoad) * (load > smoothedLoad ? loadAttack : loadRelease);
+    publishedLoad.store(smoothedLoad, std::memory_order_relaxed);
+
+    if (!enabled)
+        return;
+
+    if (smoothedLoad > 1.0f)
+    {
+        // Render cost scales roughly with the number of live grains, so aim straight
+        // for the grain count that would fit the budget.
+        const auto target = static_cast<size_t>(static_cast<float>(juce::jmin(capacity, liveGrains)) / smoothedLoad);
+        capacity = juce::jmax(minimumCapacity, juce::jmin(capacity > 0 ? capacity - 1 : 0, target));
+        spawnKeep = juce::jmax(0.1f, spawnKeep * 0.8f);
+    }
+    else if (smoothedLoad < recoveryLoad)
+    {
+        capacity = juce::jmin(nominalCapacity, capacity + juce::jmax<size_t>(1, nominalCapacity / 64));
+        spawnKeep = juce::jmin(1.0f, spawnKeep + 0.02f);
+    }
+
+    publishedCapacity.store(capacity, std::memory_order_relaxed);
+}
+
+bool GrainGovernor::shouldSpawn() noexcept
+{
+    if (spawnKeep >= 1.0f)
+        return true;
+
+    // Error-diffusion thinning keeps exactly spawnKeep of the spawns, evenly spread,
+    // without touching the engine's random sequence.
+    keepAccumulator += spawnKeep;
+    if (keepAccumulator >= 1.0f)
+    {
+        keepAccumulator -= 1.0f;
+        return true;
+    }
+
+    return false;
+}
+
+GrainGovernor::Counters GrainGovernor::getCounters() const noexcept
+{
+    Counters counters;
+    counters.spawned = spawned.load(std::memory_order_relaxed);
+    counters.stolen = stolen.load(std::memory_order_relaxed);
+    counters.dropped = dropped.load(std::memory_order_relaxed);
+    return counters;
+}
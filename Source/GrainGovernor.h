@@ -0,0 +1,77 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Keeps the grain engine inside a CPU budget. Each block's render time is measured
+// against a configurable share of the callback deadline; while the engine runs
+// over budget the governor lowers the number of grains it may keep alive and
+// thins new spawns, and it relaxes both again once there is headroom. The engine
+// does the actual voice stealing, asking getCapacity() how many grains to keep.
+class GrainGovernor
+{
+public:
+    enum class StealPolicy
+    {
+        quietest,
+        oldest
+    };
+
+    struct Counters
+    {
+        uint64_t spawned = 0;
+        uint64_t stolen = 0;
+        uint64_t dropped = 0;
+    };
+
+    void prepare(double sampleRate, size_t nominalCapacity);
+
+    // Audio thread setters.
+    void setEnabled(bool shouldBeEnabled) noexcept;
+    void setBudget(float deadlineShare) noexcept { budget = juce::jlimit(0.05f, 1.0f, deadlineShare); }
+    void setStealPolicy(StealPolicy policy) noexcept { stealPolicy = policy; }
+    StealPolicy getStealPolicy() const noexcept { return stealPolicy; }
+
+    // Audio thread: bracket every block the engine renders. liveGrains is the number
+    // of grains that were sounding while the block was rendered.
+    void blockStarted() noexcept { blockStartTicks = juce::Time::getHighResolutionTicks(); }
+    void blockFinished(int numSamples, size_t liveGrains) noexcept;
+
+    size_t getCapacity() const noexcept { return capacity; }
+
+    // Audio thread: deterministic spawn thinning; false means skip this grain.
+    bool shouldSpawn() noexcept;
+
+    void grainSpawned() noexcept { spawned.store(spawned.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+    void grainsStolen(size_t count) noexcept { stolen.store(stolen.load(std::memory_order_relaxed) + count, std::memory_order_relaxed); }
+    void grainDropped() noexcept { dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed); }
+
+    // Any thread.
+    Counters getCounters() const noexcept;
+    float getLoad() const noexcept { return publishedLoad.load(std::memory_order_relaxed); }
+    size_t getPublishedCapacity() const noexcept { return publishedCapacity.load(std::memory_order_relaxed); }
+
+private:
+    static constexpr size_t minimumCapacity = 16;
+
+    double sampleRate = 44100.0;
+    size_t nominalCapacity = 0;
+    size_t capacity = 0;
+    bool enabled = true;
+    float budget = 0.7f;
+    StealPolicy stealPolicy = StealPolicy::quietest;
+
+    float smoothedLoad = 0.0f;
+    float spawnKeep = 1.0f;
+    float keepAccumulator = 0.0f;
+    int64_t blockStartTicks = 0;
+
+    // Written by the audio thread only, read by the editor and the benchmark.
+    alignas(64) std::atomic<uint64_t> spawned { 0 };
+    alignas(64) std::atomic<uint64_t> stolen { 0 };
+    alignas(64) std::atomic<uint64_t> dropped { 0 };
+    alignas(64) std::atomic<float> publishedLoad { 0.0f };
+    std::atomic<size_t> publishedCapacity { 0 };
+};
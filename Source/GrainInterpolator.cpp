@@ -0,0 +1,80 @@
+#include "GrainInterpolator.h"
+
+#include <cmath>
+
+namespace
+{
+constexpr int rowsPerBand = GrainInterpolator::sincPhases + 1;
+
+double blackmanHarris(double x) noexcept
+{
+    // x runs over 0-1 across the kernel.
+    const auto w = juce::MathConstants<double>::twoPi * x;
+    return 0.35875 - 0.48829 * std::cos(w) + 0.14128 * std::cos(2.0 * w) - 0.01168 * std::cos(3.0 * w);
+}
+}
+
+GrainInterpolator::GrainInterpolator()
+    : sincTable(static_cast<size_t>(sincBands * rowsPerBand * sincTaps))
+{
+    constexpr auto first = firstTap(Quality::sinc);
+    constexpr auto span = static_cast<double>(sincTaps);
+
+    for (int band = 0; band < sincBands; ++band)
+    {
+        // Band b is meant for read speeds up to b + 1 samples per output sample; a
+        // little below Nyquist keeps the short kernel's transition band out of the
+        // audible top octave.
+        const auto cutoff = 0.9 / static_cast<double>(band + 1);
+
+        for (int phase = 0; phase < rowsPerBand; ++phase)
+        {
+            const auto fraction = static_cast<double>(phase) / static_cast<double>(sincPhases);
+            auto* row = sincTable.data() + static_cast<size_t>((band * rowsPerBand + phase) * sincTaps);
+            double sum = 0.0;
+
+            for (int k = 0; k < sincTaps; ++k)
+            {
+                const auto x = static_cast<double>(first + k) - fraction;
+                const auto arg = juce::MathConstants<double>::pi * cutoff * x;
+                const auto sincValue = std::abs(x) < 1.0e-9 ? 1.0 : std::sin(arg) / arg;
+                const auto coefficient = cutoff * sincValue * blackmanHarris((x - first + 1.0) / (span + 1.0));
+                row[k] = static_cast<float>(coefficient);
+                sum += coefficient;
+            }
+
+            // Unity gain at DC for every phase, so pitched grains do not ripple in level.
+            for (int k = 0; k < sincTaps; ++k)
+                row[k] = static_cast<float>(row[k] / sum);
+        }
+    }
+}
+
+int GrainInterpolator::sincBandForSpeed(float samplesPerOutputSample) noexcept
+{
+    return juce::jlimit(0, sincBands - 1, static_cast<int>(std::ceil(samplesPerOutputSample)) - 1);
+}
+
+GrainInterpolator::FloatVector GrainInterpolator::sinc(const FloatVector* taps, const float* fractions, const int* bands) const noexcept
+{
+    constexpr auto laneWidth = FloatVector::SIMDNumElements;
+    alignas(64) float coefficients[sincTaps][laneWidth];
+
+    for (size_t l = 0; l < laneWidth; ++l)
+    {
+        const auto position = juce::jlimit(0.0f, static_cast<float>(sincPhases), fractions[l] * static_cast<float>(sincPhases));
+        const auto phase = juce::jmin(static_cast<int>(position), sincPhases - 1);
+        const auto blend = position - static_cast<float>(phase);
+        const auto* rowA = sincTable.data() + static_cast<size_t>((bands[l] * rowsPerBand + phase) * sincTaps);
+        const auto* rowB = rowA + sincTaps;
+
+        for (int k = 0; k < sincTaps; ++k)
+            coefficients[k][l] = rowA[k] + (rowB[k] - rowA[k]) * blend;
+    }
+
+    auto result = FloatVector::expand(0.0f);
+    for (int k = 0; k < sincTaps; ++k)
+        result += taps[k] * FloatVector::fromRawArray(coefficients[k]);
+
+    return result;
+}
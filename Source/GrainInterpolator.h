@@ -0,0 +1,92 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+// Fractional delay-line readers for grain playback, from cheapest to cleanest.
+// Every kernel works on a whole SIMD group at once: taps[k] holds sample
+// (index + firstTap + k) for each lane and t the lanes' fractional positions.
+class GrainInterpolator
+{
+public:
+    using FloatVector = juce::dsp::SIMDRegister<float>;
+
+    enum class Quality
+    {
+        linear = 0, // 2 points
+        hermite,    // 4-point, third-order Catmull-Rom
+        lagrange6,  // 6-point, fifth-order Lagrange
+        sinc        // 8-point windowed sinc from a polyphase table
+    };
+
+    static constexpr int numQualities = 4;
+
+    static constexpr int numTaps(Quality quality) noexcept
+    {
+        return quality == Quality::linear ? 2 : quality == Quality::hermite ? 4 : quality == Quality::lagrange6 ? 6 : sincTaps;
+    }
+
+    // Offset of taps[0] from the integer read index.
+    static constexpr int firstTap(Quality quality) noexcept { return 1 - numTaps(quality) / 2; }
+
+    // Widest footprint of any kernel around the read index.
+    static constexpr int maxTapsBefore = 3;
+    static constexpr int maxTapsAfter = 4;
+
+    static constexpr int sincTaps = 8;
+    static constexpr int sincPhases = 256;
+    static constexpr int sincBands = 4;
+
+    // Builds the sinc table; message thread.
+    GrainInterpolator();
+
+    // Grains that move through the delay line faster than one sample per output
+    // sample need a lower cutoff to stay alias-free. Returns the sinc band for a
+    // read speed, chosen once when the grain spawns.
+    static int sincBandForSpeed(float samplesPerOutputSample) noexcept;
+
+    static FloatVector linear(const FloatVector* taps, FloatVector t) noexcept
+    {
+        return taps[0] + (taps[1] - taps[0]) * t;
+    }
+
+    static FloatVector hermite(const FloatVector* taps, FloatVector t) noexcept
+    {
+        const auto c1 = (taps[2] - taps[0]) * 0.5f;
+        const auto c2 = taps[0] - taps[1] * 2.5f + taps[2] * 2.0f - taps[3] * 0.5f;
+        const auto c3 = (taps[3] - taps[0]) * 0.5f + (taps[1] - taps[2]) * 1.5f;
+        return ((c3 * t + c2) * t + c1) * t + taps[1];
+    }
+
+    static FloatVector lagrange6(const FloatVector* taps, FloatVector t) noexcept
+    {
+        // Taps sit at -2..3. Each weight is the product of (t - j) over the other
+        // five nodes, built from running prefix and suffix products.
+        const FloatVector d[6] { t + 2.0f, t + 1.0f, t, t - 1.0f, t - 2.0f, t - 3.0f };
+        static constexpr float denominators[6] { -120.0f, 24.0f, -12.0f, 12.0f, -24.0f, 120.0f };
+
+        FloatVector prefix[6];
+        prefix[0] = FloatVector::expand(1.0f);
+        for (int k = 1; k < 6; ++k)
+            prefix[k] = prefix[k - 1] * d[k - 1];
+
+        auto suffix = FloatVector::expand(1.0f);
+        auto result = FloatVector::expand(0.0f);
+        for (int k = 5; k >= 0; --k)
+        {
+            result += taps[k] * (prefix[k] * suffix) * (1.0f / denominators[k]);
+            suffix *= d[k];
+        }
+
+        return result;
+    }
+
+    // Phase interpolation between neighbouring table rows happens lane by lane; the
+    // convolution itself runs across the group.
+    FloatVector sinc(const FloatVector* taps, const float* fractions, const int* bands) const noexcept;
+
+private:
+    // sincBands blocks of (sincPhases + 1) rows of sincTaps coefficients. The extra
+    // row per band is phase 1.0, so the interpolated lookup never wraps.
+    std::vector<float> sincTable;
+};
@@ -0,0 +1,239 @@
+#include "GrainPanner.h"
+
+#include <algorithm>
+#include <cmath>
+#include <optional>
+
+namespace
+{
+using ChannelType = juce::AudioChannelSet::ChannelType;
+
+constexpr auto pi = juce::MathConstants<float>::pi;
+constexpr auto halfPi = juce::MathConstants<float>::halfPi;
+constexpr auto twoPi = juce::MathConstants<float>::twoPi;
+
+// Where a stereo pair's speakers sit, which maps a source's azimuth onto the pan law.
+constexpr auto stereoSpeakerAzimuth = pi / 6.0f;
+
+// Ear-level speaker directions, anticlockwise from the front. LFE, height and
+// unknown channels have no place on the ring.
+std::optional<float> speakerAzimuth(ChannelType type)
+{
+    switch (type)
+    {
+        case ChannelType::left:              return 30.0f;
+        case ChannelType::right:             return -30.0f;
+        case ChannelType::centre:            return 0.0f;
+        case ChannelType::leftCentre:        return 15.0f;
+        case ChannelType::rightCentre:       return -15.0f;
+        case ChannelType::wideLeft:          return 60.0f;
+        case ChannelType::wideRight:         return -60.0f;
+        case ChannelType::leftSurroundSide:  return 90.0f;
+        case ChannelType::rightSurroundSide: return -90.0f;
+        case ChannelType::leftSurround:      return 110.0f;
+        case ChannelType::rightSurround:     return -110.0f;
+        case ChannelType::leftSurroundRear:  return 150.0f;
+        case ChannelType::rightSurroundRear: return -150.0f;
+        case ChannelType::centreSurround:    return 180.0f;
+        default:                             return std::nullopt;
+    }
+}
+
+int countRingSpeakers(const juce::AudioChannelSet& layout)
+{
+    if (layout.isDiscreteLayout())
+        return layout.size();
+
+    int count = 0;
+    for (int channel = 0; channel < layout.size(); ++channel)
+        if (speakerAzimuth(layout.getTypeOfChannel(channel)).has_value())
+            ++count;
+    return count;
+}
+
+void stereoGains(float position, float* gains) noexcept
+{
+    gains[0] = std::cos(position * halfPi);
+    gains[1] = std::sin(position * halfPi);
+}
+
+double factorial(int n)
+{
+    auto result = 1.0;
+    for (int i = 2; i <= n; ++i)
+        result *= i;
+    return result;
+}
+
+double doubleFactorial(int n)
+{
+    auto result = 1.0;
+    for (int i = n; i > 1; i -= 2)
+        result *= i;
+    return result;
+}
+
+// SN3D-normalised spherical harmonic of degree l and order |m| at zero elevation,
+// without the azimuth term: N(l, m) P(l, m)(0), with no Condon-Shortley phase.
+float horizontalHarmonicWeight(int l, int m)
+{
+    m = std::abs(m);
+    if ((l + m) % 2 != 0)
+        return 0.0f;
+
+    const auto normalisation = std::sqrt((m == 0 ? 1.0 : 2.0) * factorial(l - m) / factorial(l + m));
+    const auto legendre = doubleFactorial(l + m - 1) / doubleFactorial(l - m) * (((l - m) / 2) % 2 == 0 ? 1.0 : -1.0);
+    return static_cast<float>(normalisation * legendre);
+}
+}
+
+bool GrainPanner::supportsLayout(const juce::AudioChannelSet& layout)
+{
+    if (layout.isDisabled() || layout.size() > maxChannels)
+        return false;
+
+    if (const auto order = layout.getAmbisonicOrder(); order >= 0)
+        return order >= 1 && order <= 3;
+
+    if (layout == juce::AudioChannelSet::mono() || layout == juce::AudioChannelSet::stereo())
+        return true;
+
+    return countRingSpeakers(layout) >= 2;
+}
+
+void GrainPanner::setLayout(const juce::AudioChannelSet& layout)
+{
+    jassert(supportsLayout(layout));
+    numChannels = juce::jlimit(1, maxChannels, layout.size());
+
+    if (const auto order = layout.getAmbisonicOrder(); order >= 1)
+        setAmbisonic(juce::jmin(order, 3));
+    else if (layout == juce::AudioChannelSet::stereo())
+        mode = Mode::stereo;
+    else if (numChannels == 1)
+        mode = Mode::mono;
+    else
+        setRing(layout);
+}
+
+void GrainPanner::setRing(const juce::AudioChannelSet& layout)
+{
+    mode = Mode::ring;
+    numSpeakers = 0;
+
+    // Discrete layouts have no speaker positions: channel 1 faces front and the rest
+    // follow clockwise at even spacing, as installation rings are usually patched.
+    const auto discrete = layout.isDiscreteLayout();
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        std::optional<float> azimuth;
+        if (discrete)
+            azimuth = -twoPi * static_cast<float>(channel) / static_cast<float>(numChannels);
+        else if (const auto degrees = speakerAzimuth(layout.getTypeOfChannel(channel)))
+            azimuth = juce::degreesToRadians(*degrees);
+
+        if (azimuth.has_value())
+            speakers[static_cast<size_t>(numSpeakers++)] = { std::remainder(*azimuth, twoPi), channel };
+    }
+
+    std::sort(speakers.begin(), speakers.begin() + numSpeakers,
+              [](const Speaker& a, const Speaker& b) { return a.azimuth < b.azimuth; });
+}
+
+void GrainPanner::setAmbisonic(int order)
+{
+    mode = Mode::ambisonic;
+    numChannels = juce::jmin(maxChannels, (order + 1) * (order + 1));
+
+    // ACN orders the channels by degree l, then by m from -l to l.
+    for (int l = 0, channel = 0; l <= order; ++l)
+    {
+        for (int m = -l; m <= l && channel < numChannels; ++m, ++channel)
+        {
+            harmonicWeights[static_cast<size_t>(channel)] = horizontalHarmonicWeight(l, m);
+            harmonicDegrees[static_cast<size_t>(channel)] = m;
+        }
+    }
+}
+
+void GrainPanner::getGains(float position, float* gains) const noexcept
+{
+    position = juce::jlimit(0.0f, 1.0f, position);
+
+    switch (mode)
+    {
+        case Mode::mono:   gains[0] = 1.0f; break;
+        case Mode::stereo: stereoGains(position, gains); break;
+        case Mode::ring:
+        case Mode::ambisonic:
+            getGainsForAzimuth(pi * (1.0f - 2.0f * position), gains);
+            break;
+    }
+}
+
+void GrainPanner::getPairGains(float position, float* leftGains, float* rightGains) const noexcept
+{
+    position = juce::jlimit(0.0f, 1.0f, position);
+
+    if (mode == Mode::stereo)
+    {
+        // Half the bus either side of the centre, which is where the speakers sit.
+        stereoGains(juce::jmax(0.0f, position - 0.5f), leftGains);
+        stereoGains(juce::jmin(1.0f, position + 0.5f), rightGains);
+        return;
+    }
+
+    const auto centre = pi * (1.0f - 2.0f * position);
+    getGainsForAzimuth(centre + stereoSpeakerAzimuth, leftGains);
+    getGainsForAzimuth(centre - stereoSpeakerAzimuth, rightGains);
+}
+
+void GrainPanner::getGainsForAzimuth(float azimuth, float* gains) const noexcept
+{
+    std::fill(gains, gains + numChannels, 0.0f);
+    azimuth = std::remainder(azimuth, twoPi);
+
+    if (mode == Mode::mono)
+    {
+        gains[0] = 1.0f;
+    }
+    else if (mode == Mode::stereo)
+    {
+        stereoGains(juce::jlimit(0.0f, 1.0f, 0.5f - 0.5f * azimuth / stereoSpeakerAzimuth), gains);
+    }
+    else if (mode == Mode::ambisonic)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            const auto degree = harmonicDegrees[static_cast<size_t>(channel)];
+            const auto angle = static_cast<float>(std::abs(degree)) * azimuth;
+            gains[channel] = harmonicWeights[static_cast<size_t>(channel)] * (degree >= 0 ? std::cos(angle) : std::sin(angle));
+        }
+    }
+    else if (numSpeakers == 1)
+    {
+        gains[speakers[0].channel] = 1.0f;
+    }
+    else if (numSpeakers > 1)
+    {
+        // Constant-power pan between the nearest speakers on either side.
+        int next = 0;
+        while (next < numSpeakers && speakers[static_cast<size_t>(next)].azimuth < azimuth)
+            ++next;
+
+        const auto& after = speakers[static_cast<size_t>(next % numSpeakers)];
+        const auto& before = speakers[static_cast<size_t>((next + numSpeakers - 1) % numSpeakers)];
+
+        auto arc = after.azimuth - before.azimuth;
+        if (arc <= 0.0f)
+            arc += twoPi;
+        auto offset = azimuth - before.azimuth;
+        if (offset < 0.0f)
+            offset += twoPi;
+
+        const auto fraction = juce::jlimit(0.0f, 1.0f, offset / arc);
+        gains[before.channel] += std::cos(fraction * halfPi);
+        gains[after.channel] += std::sin(fraction * halfPi);
+    }
+}
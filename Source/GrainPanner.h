@@ -0,0 +1,74 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <array>
+
+// Spreads a grain over the channels of an output bus. Stereo buses keep the
+// equal-power pan law; surround buses pan between the two neighbouring speakers
+// around the listener; ambisonic buses (ACN order, SN3D) encode the grain on the
+// horizontal plane. LFE and height speakers get no grains.
+//
+// A grain's position runs from 0 (hard left) through 0.5 (front centre) to 1 (hard
+// right). Surround and ambisonic buses wrap it round the whole circle instead: 0.25
+// is hard left, 0.75 hard right, and both ends meet behind the listener.
+class GrainPanner
+{
+public:
+    // Third-order ambisonics, or a 9.1.6 bed.
+    static constexpr int maxChannels = 16;
+
+    // Whether setLayout() can place grains on the layout: mono, stereo, any surround
+    // layout with at least two ear-level speakers, a discrete layout (treated as an
+    // evenly spaced ring) or ambisonics up to third order, within maxChannels.
+    static bool supportsLayout(const juce::AudioChannelSet& layout);
+
+    // Message thread, before processing.
+    void setLayout(const juce::AudioChannelSet& layout);
+
+    int getNumChannels() const noexcept { return numChannels; }
+    bool isAmbisonic() const noexcept { return mode == Mode::ambisonic; }
+
+    // Audio thread: fills getNumChannels() gains for a grain at the given position.
+    void getGains(float position, float* gains) const noexcept;
+
+    // Audio thread: fills getNumChannels() gains for each side of a stereo pair whose
+    // centre sits at the given position. The pair keeps the width of a stereo
+    // speaker pair and rotates with its centre, so the ends of a stereo bus fold
+    // both sides onto one speaker.
+    void getPairGains(float position, float* leftGains, float* rightGains) const noexcept;
+
+    // Any thread: fills getNumChannels() gains for a source at the given azimuth, in
+    // radians anticlockwise from the front (so the left speaker of a stereo pair sits
+    // at +30 degrees).
+    void getGainsForAzimuth(float azimuth, float* gains) const noexcept;
+
+private:
+    enum class Mode
+    {
+        mono,
+        stereo,
+        ring,
+        ambisonic
+    };
+
+    struct Speaker
+    {
+        float azimuth = 0.0f;
+        int channel = 0;
+    };
+
+    void setRing(const juce::AudioChannelSet& layout);
+    void setAmbisonic(int order);
+
+    Mode mode = Mode::stereo;
+    int numChannels = 2;
+
+    // Ring: the ear-level speakers sorted by azimuth.
+    std::array<Speaker, maxChannels> speakers {};
+    int numSpeakers = 0;
+
+    // Ambisonic: each channel's weight and angular frequency at zero elevation. A
+    // negative frequency selects the sine component.
+    std::array<float, maxChannels> harmonicWeights {};
+    std::array<int, maxChannels> harmonicDegrees {};
+};
@@ -0,0 +1,159 @@
+#include "GrainRenderPool.h"
+
+namespace
+{
+// Workers poll for a fresh job for this many iterations after finishing one before
+// going to sleep. Consecutive audio callbacks usually arrive well within it, so
+// the audio thread rarely has to signal an event.
+constexpr int spinIterations = 2000;
+}
+
+class GrainRenderPool::Worker : public juce::Thread
+{
+public:
+    Worker(GrainRenderPool& ownerToUse, int index)
+        : juce::Thread("Cosmic Grain Worker " + juce::String(index)), owner(ownerToUse)
+    {
+    }
+
+    ~Worker() override
+    {
+        signalThreadShouldExit();
+        wakeUp.signal();
+        stopThread(2000);
+    }
+
+    void run() override
+    {
+        juce::WorkgroupToken token;
+        uint32_t joinedWorkgroup = 0;
+        uint32_t lastGeneration = static_cast<uint32_t>(owner.work.load(std::memory_order_acquire) >> 32);
+
+        while (!threadShouldExit())
+        {
+            const auto wantedWorkgroup = owner.workgroupGeneration.load(std::memory_order_acquire);
+            if (wantedWorkgroup != joinedWorkgroup)
+            {
+                token.reset();
+                const juce::SpinLock::ScopedLockType lock(owner.workgroupLock);
+                if (owner.workgroup)
+                    owner.workgroup.join(token);
+                joinedWorkgroup = wantedWorkgroup;
+            }
+
+            auto generation = static_cast<uint32_t>(owner.work.load(std::memory_order_acquire) >> 32);
+            for (int spin = 0; generation == lastGeneration && spin < spinIterations; ++spin)
+            {
+                juce::Thread::yield();
+                generation = static_cast<uint32_t>(owner.work.load(std::memory_order_acquire) >> 32);
+            }
+
+            if (generation == lastGeneration)
+            {
+                owner.sleepingWorkers.fetch_add(1);
+
+                // Re-check after announcing we are asleep, so a job published in
+                // between is not missed. Both sides use sequentially consistent
+                // operations here: either this load sees the new job or run() sees
+                // the sleeper and signals.
+                if (static_cast<uint32_t>(owner.work.load() >> 32) == lastGeneration)
+                    wakeUp.wait(50.0);
+
+                owner.sleepingWorkers.fetch_sub(1);
+                continue;
+            }
+
+            lastGeneration = generation;
+            owner.workOn(generation);
+        }
+    }
+
+    juce::WaitableEvent wakeUp;
+
+private:
+    GrainRenderPool& owner;
+};
+
+GrainRenderPool::GrainRenderPool(int numWorkers, double sampleRate, int blockSize)
+{
+    const auto options = juce::Thread::RealtimeOptions{}.withApproximateAudioProcessingTime(juce::jmax(1, blockSize), sampleRate);
+
+    for (int i = 0; i < numWorkers; ++i)
+    {
+        auto worker = std::make_unique<Worker>(*this, i + 1);
+        if (!worker->startRealtimeThread(options))
+            worker->startThread(juce::Thread::Priority::highest);
+        workers.push_back(std::move(worker));
+    }
+}
+
+GrainRenderPool::~GrainRenderPool()
+{
+    workers.clear();
+}
+
+void GrainRenderPool::setWorkgroup(const juce::AudioWorkgroup& newWorkgroup)
+{
+    {
+        const juce::SpinLock::ScopedLockType lock(workgroupLock);
+        workgroup = newWorkgroup;
+    }
+
+    workgroupGeneration.fetch_add(1, std::memory_order_acq_rel);
+}
+
+void GrainRenderPool::run(Client& client, int numChunks) noexcept
+{
+    if (numChunks <= 0)
+        return;
+
+    numChunks = juce::jmin(numChunks, maxChunks);
+    currentClient = &client;
+    chunksCompleted.store(0, std::memory_order_relaxed);
+
+    const auto generation = static_cast<uint32_t>(work.load(std::memory_order_relaxed) >> 32) + 1;
+    work.store((static_cast<uint64_t>(generation) << 32) | (static_cast<uint64_t>(numChunks) << 16));
+
+    if (sleepingWorkers.load() > 0)
+        for (auto& worker : workers)
+            worker->wakeUp.signal();
+
+    workOn(generation);
+
+    // Only chunks a worker is rendering right now can be outstanding here, so this
+    // wait is bounded by a single chunk's render time.
+    while (chunksCompleted.load(std::memory_order_acquire) < numChunks)
+        juce::Thread::yield();
+}
+
+bool GrainRenderPool::claimChunk(uint32_t generation, int& chunkOut) noexcept
+{
+    auto current = work.load(std::memory_order_acquire);
+
+    for (;;)
+    {
+        if (static_cast<uint32_t>(current >> 32) != generation)
+            return false;
+
+        const auto chunk = static_cast<int>(current & 0xffff);
+        const auto numChunks = static_cast<int>((current >> 16) & 0xffff);
+        if (chunk >= numChunks)
+            return false;
+
+        if (work.compare_exchange_weak(current, current + 1, std::memory_order_acq_rel, std::memory_order_acquire))
+        {
+            chunkOut = chunk;
+            return true;
+        }
+    }
+}
+
+void GrainRenderPool::workOn(uint32_t generation) noexcept
+{
+    int chunk = 0;
+    while (claimChunk(generation, chunk))
+    {
+        currentClient->renderChunk(chunk);
+        chunksCompleted.fetch_add(1, std::memory_order_acq_rel);
+    }
+}
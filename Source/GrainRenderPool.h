@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Small pool of real-time worker threads that help the audio thread through a
+// job split into independent chunks. The audio thread publishes a job, works on
+// it itself, and returns once every chunk is done; workers claim chunks from a
+// shared atomic counter, so a worker that wakes late simply finds less to do.
+// Workers join the host's audio workgroup when one is provided.
+class GrainRenderPool
+{
+public:
+    struct Client
+    {
+        virtual ~Client() = default;
+        // Called concurrently for distinct chunk indices of the current job.
+        virtual void renderChunk(int chunkIndex) noexcept = 0;
+    };
+
+    // Message thread only, while no job is running.
+    GrainRenderPool(int numWorkers, double sampleRate, int blockSize);
+    ~GrainRenderPool();
+
+    int getNumWorkers() const noexcept { return static_cast<int>(workers.size()); }
+
+    static constexpr int maxChunks = 0xffff;
+
+    // Message thread: workers (re)join this workgroup before their next job.
+    void setWorkgroup(const juce::AudioWorkgroup& workgroup);
+
+    // Audio thread: renders chunks [0, numChunks) and returns when all are done.
+    // numChunks is capped at maxChunks.
+    void run(Client& client, int numChunks) noexcept;
+
+private:
+    class Worker;
+
+    bool claimChunk(uint32_t generation, int& chunkOut) noexcept;
+    void workOn(uint32_t generation) noexcept;
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    // Bits 32-63: job generation. Bits 16-31: chunk count. Bits 0-15: next unclaimed
+    // chunk. Keeping all three in one word means a worker can never pair one job's
+    // generation with another job's chunk count.
+    alignas(64) std::atomic<uint64_t> work { 0 };
+    alignas(64) std::atomic<int> chunksCompleted { 0 };
+    alignas(64) std::atomic<int> sleepingWorkers { 0 };
+
+    // Written before the generation is published and read only after a successful
+    // claim, which keeps the job from completing until that chunk is done.
+    Client* currentClient = nullptr;
+
+    juce::SpinLock workgroupLock;
+    juce::AudioWorkgroup workgroup;
+    std::atomic<uint32_t> workgroupGeneration { 0 };
+};
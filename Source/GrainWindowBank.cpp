@@ -0,0 +1,149 @@
+#include "GrainWindowBank.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+// Width of the raised-cosine kernel that band-limits each table. Closed forms with
+// corners (trapezoid, Tukey at small tapers) would otherwise
+// put an audible click at every breakpoint of every grain.
+constexpr int smoothingRadius = 4;
+
+float sineArc(float t, float amount)
+{
+    const auto base = std::sin(t * juce::MathConstants<float>::pi);
+    return base <= 0.0f ? 0.0f : std::pow(base, juce::jmap(amount, 0.0f, 1.0f, 0.5f, 4.0f));
+}
+
+float skewedHann(float t, float amount)
+{
+    // Gravity Envelope moves the peak: 0.5 is a symmetric Hann, lower values give
+    // a fast attack and long decay, higher values the reverse.
+    const auto peak = juce::jmap(amount, 0.0f, 1.0f, 0.1f, 0.9f);
+    const auto warped = t < peak ? 0.5f * t / peak : 0.5f + 0.5f * (t - peak) / (1.0f - peak);
+    return 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * warped);
+}
+
+float tukey(float t, float amount)
+{
+    const auto taper = juce::jmap(amount, 0.0f, 1.0f, 0.05f, 1.0f);
+    const auto edge = juce::jmin(t, 1.0f - t);
+    if (edge >= 0.5f * taper)
+        return 1.0f;
+    return 0.5f - 0.5f * std::cos(juce::MathConstants<float>::twoPi * edge / taper);
+}
+
+float gaussian(float t, float amount)
+{
+    // Shifted and rescaled so the window still starts and ends at exactly zero.
+    const auto sigma = juce::jmap(amount, 0.0f, 1.0f, 0.35f, 0.08f);
+    const auto curve = [sigma](float x) { return std::exp(-0.5f * juce::square((x - 0.5f) / sigma)); };
+    const auto floor = curve(0.0f);
+    return juce::jmax(0.0f, (curve(t) - floor) / (1.0f - floor));
+}
+
+float trapezoid(float t, float amount)
+{
+    const auto ramp = juce::jmap(amount, 0.0f, 1.0f, 0.02f, 0.5f);
+    return juce::jmin(1.0f, juce::jmin(t, 1.0f - t) / ramp);
+}
+}
+
+GrainWindowBank::GrainWindowBank()
+{
+    tables.forEachBuffer([](Table& table) { fillTable(table, Shape::sineArc, 0.5f); });
+}
+
+void GrainWindowBank::requestShape(Shape shape, float amount) noexcept
+{
+    if (shape == lastShape && amount == lastAmount)
+        return;
+
+    lastShape = shape;
+    lastAmount = amount;
+    requestedShape.store(static_cast<int>(shape), std::memory_order_relaxed);
+    requestedAmount.store(amount, std::memory_order_relaxed);
+    requestGeneration.fetch_add(1, std::memory_order_release);
+}
+
+bool GrainWindowBank::rebuildIfNeeded()
+{
+    // The background thread and a synchronous prepare() may both get here; only
+    // one of them may own the triple buffer's write slot at a time.
+    const juce::SpinLock::ScopedLockType lock(buildLock);
+
+    const auto generation = requestGeneration.load(std::memory_order_acquire);
+    if (generation == builtGeneration)
+        return false;
+
+    builtGeneration = generation;
+    const auto shape = static_cast<Shape>(requestedShape.load(std::memory_order_relaxed));
+    const auto amount = requestedAmount.load(std::memory_order_relaxed);
+
+    fillTable(tables.getWriteBuffer(), shape, amount);
+    tables.publish();
+    return true;
+}
+
+int GrainWindowBank::useTimeSlice()
+{
+    // Parameter moves arrive in bursts; poll quickly while they do, then back off.
+    return rebuildIfNeeded() ? 5 : 20;
+}
+
+void GrainWindowBank::fillTable(Table& table, Shape shape, float amount)
+{
+    amount = juce::jlimit(0.0f, 1.0f, amount);
+
+    std::array<float, tableSize + 1 + 2 * smoothingRadius> raw {};
+    for (int i = 0; i <= tableSize; ++i)
+    {
+        const auto t = static_cast<float>(i) / static_cast<float>(tableSize);
+        float value = 0.0f;
+
+        switch (shape)
+        {
+            case Shape::sineArc:   value = sineArc(t, amount); break;
+            case Shape::hann:      value = skewedHann(t, amount); break;
+            case Shape::tukey:     value = tukey(t, amount); break;
+            case Shape::gaussian:  value = gaussian(t, amount); break;
+            case Shape::trapezoid: value = trapezoid(t, amount); break;
+        }
+
+        raw[(size_t) (i + smoothingRadius)] = juce::jlimit(0.0f, 1.0f, value);
+    }
+
+    std::array<float, 2 * smoothingRadius + 1> kernel {};
+    float kernelSum = 0.0f;
+    for (int k = -smoothingRadius; k <= smoothingRadius; ++k)
+    {
+        const auto w = 0.5f + 0.5f * std::cos(juce::MathConstants<float>::pi * static_cast<float>(k) / static_cast<float>(smoothingRadius + 1));
+        kernel[(size_t) (k + smoothingRadius)] = w;
+        kernelSum += w;
+    }
+
+    float peak = 0.0f;
+    for (int i = 0; i <= tableSize; ++i)
+    {
+        float acc = 0.0f;
+        for (int k = 0; k < static_cast<int>(kernel.size()); ++k)
+            acc += raw[(size_t) (i + k)] * kernel[(size_t) k];
+
+        table.values[(size_t) i] = acc / kernelSum;
+        peak = juce::jmax(peak, table.values[(size_t) i]);
+    }
+
+    // Pin the ends to silence and restore unity peak gain lost to the smoothing.
+    const auto gain = peak > 0.0f ? 1.0f / peak : 0.0f;
+    for (auto& value : table.values)
+        value *= gain;
+
+    table.values.front() = 0.0f;
+    table.values.back() = 0.0f;
+
+    float energy = 0.0f;
+    for (int i = 0; i < tableSize; ++i)
+        energy += table.values[(size_t) i] * table.values[(size_t) i];
+    table.meanSquare = energy / static_cast<float>(tableSize);
+}
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "TripleBuffer.h"
+
+// Precomputed grain window tables. The audio thread only ever reads a published
+// table (one linear-interpolated lookup per grain per sample); building a table
+// with its sin/pow/exp calls happens on a background TimeSliceThread whenever the
+// window type or the Gravity Envelope amount changes.
+class GrainWindowBank : public juce::TimeSliceClient
+{
+public:
+    enum class Shape
+    {
+        sineArc = 0, // sin(pi t)^k, the original envelope family
+        hann,
+        tukey,
+        gaussian,
+        trapezoid
+    };
+
+    static constexpr int numShapes = 5;
+    static constexpr int tableSize = 1024;
+
+    struct Table
+    {
+        // One guard point past the end so the interpolated read never wraps.
+        std::array<float, tableSize + 1> values {};
+        // The mean of the squared window: the share of its input's energy a grain passes.
+        float meanSquare = 0.0f;
+    };
+
+    GrainWindowBank();
+
+    // Audio thread: cheap atomic stores, the table itself is rebuilt elsewhere.
+    void requestShape(Shape shape, float amount) noexcept;
+
+    // Builds a table for the latest request if it changed since the last build.
+    // Called from the background thread, or synchronously when no thread runs it.
+    bool rebuildIfNeeded();
+
+    // Audio thread: swaps in the newest published table, if any, and returns it.
+    const Table& acquireTable() noexcept
+    {
+        tables.acquireLatest();
+        return tables.getReadBuffer();
+    }
+
+    static float lookup(const Table& table, float position) noexcept
+    {
+        const auto scaled = juce::jlimit(0.0f, static_cast<float>(tableSize), position * static_cast<float>(tableSize));
+        const auto index = juce::jmin(static_cast<int>(scaled), tableSize - 1);
+        const auto frac = scaled - static_cast<float>(index);
+        const auto a = table.values[static_cast<size_t>(index)];
+        return a + (table.values[static_cast<size_t>(index) + 1] - a) * frac;
+    }
+
+    int useTimeSlice() override;
+
+private:
+    static void fillTable(Table& table, Shape shape, float amount);
+
+    TripleBuffer<Table> tables;
+
+    std::atomic<int> requestedShape { static_cast<int>(Shape::sineArc) };
+    std::atomic<float> requestedAmount { 0.5f };
+    std::atomic<uint32_t> requestGeneration { 0 };
+    uint32_t builtGeneration = 0;
+    juce::SpinLock buildLock;
+
+    // Last values seen by requestShape(), so an unchanged parameter costs nothing.
+    Shape lastShape = Shape::sineArc;
+    float lastAmount = 0.5f;
+};
@@ -0,0 +1,426 @@
+#include "NebulaReverb.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+// Line lengths are spread geometrically over this range and rounded to primes so
+// no two lines share echo times.
+constexpr double shortestLineSeconds = 0.0297;
+constexpr double longestLineSeconds = 0.0893;
+
+// Horizon maps to the same per-pass feedback the Freeverb comb filters used over
+// their average loop length, so existing sessions keep their decay time.
+constexpr double referenceLoopSeconds = 0.0306;
+constexpr float minimumFeedback = 0.7f;
+constexpr float feedbackRange = 0.28f;
+constexpr float dampingScale = 0.4f;
+
+// A slow, shallow delay modulation per line breaks up metallic resonances without
+// audible chorusing. It fades out while frozen, where the interpolation would
+// otherwise slowly dull the held tail.
+constexpr double modulationDepthSeconds = 0.0003;
+constexpr double slowestModulationHz = 0.13;
+constexpr double fastestModulationHz = 0.87;
+
+// Roughly matches the wet level of the Freeverb this replaced.
+constexpr float wetScale = 1.5f;
+
+bool isPrime(int value) noexcept
+{
+    if (value < 2)
+        return false;
+
+    for (int divisor = 2; divisor * divisor <= value; ++divisor)
+        if (value % divisor == 0)
+            return false;
+
+    return true;
+}
+
+int nextPrime(int value) noexcept
+{
+    while (!isPrime(value))
+        ++value;
+    return value;
+}
+
+// Entry (row, column) of a Sylvester Hadamard matrix.
+float hadamardSign(int row, int column) noexcept
+{
+    int parity = 0;
+    for (int bits = row & column; bits != 0; bits &= bits - 1)
+        parity ^= 1;
+    return parity != 0 ? -1.0f : 1.0f;
+}
+}
+
+void NebulaReverb::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    sampleRate = spec.sampleRate;
+    modulationDepth = static_cast<float>(modulationDepthSeconds * sampleRate);
+
+    const auto longest = nextPrime(static_cast<int>(longestLineSeconds * sampleRate))
+                       + 2 * static_cast<int>(std::ceil(modulationDepth)) + 2;
+    lineStride = juce::nextPowerOfTwo(longest);
+    lineMask = lineStride - 1;
+    delayMemory.assign(static_cast<size_t>(maxLines * lineStride), 0.0f);
+
+    configureLines();
+    reset();
+}
+
+void NebulaReverb::reset() noexcept
+{
+    std::fill(delayMemory.begin(), delayMemory.end(), 0.0f);
+    for (auto& line : lines)
+    {
+        line.dampingState = 0.0f;
+        line.feedbackGain = line.targetFeedbackGain;
+    }
+    writePosition = 0;
+
+    for (auto* ramp : { &damping, &inputGain, &modulation, &wet1, &wet2 })
+        ramp->start = ramp->target;
+}
+
+void NebulaReverb::setParameters(const Parameters& newParameters) noexcept
+{
+    parameters = newParameters;
+    updateTargets();
+}
+
+void NebulaReverb::setLineChoice(int choice) noexcept
+{
+    choice = juce::jlimit(0, numLineChoices - 1, choice);
+    if (choice == lineChoice)
+        return;
+
+    lineChoice = choice;
+    configureLines();
+    reset();
+}
+
+void NebulaReverb::configureLines() noexcept
+{
+    numLines = linesForChoice(lineChoice);
+
+    const auto span = static_cast<double>(numLines - 1);
+    const auto injection = 1.0f / std::sqrt(static_cast<float>(numLines / 2));
+
+    for (int i = 0; i < numLines; ++i)
+    {
+        auto& line = lines[static_cast<size_t>(i)];
+
+        const auto seconds = shortestLineSeconds * std::pow(longestLineSeconds / shortestLineSeconds, static_cast<double>(i) / span);
+        line.baseDelay = static_cast<float>(nextPrime(static_cast<int>(seconds * sampleRate)));
+        jassert(line.baseDelay > static_cast<float>(chunkSize + 1));
+
+        // Rates are interleaved so neighbouring lines never drift together.
+        const auto rateIndex = (i * 5) % numLines;
+        const auto rate = slowestModulationHz + (fastestModulationHz - slowestModulationHz) * static_cast<double>(rateIndex) / span;
+        const auto step = juce::MathConstants<double>::twoPi * rate / sampleRate;
+        const auto startPhase = juce::MathConstants<double>::twoPi * static_cast<double>(i) / static_cast<double>(numLines);
+        line.lfoSin = static_cast<float>(std::sin(startPhase));
+        line.lfoCos = static_cast<float>(std::cos(startPhase));
+        line.lfoStep = static_cast<float>(step);
+        line.chunkRotateSin = static_cast<float>(std::sin(step * chunkSize));
+        line.chunkRotateCos = static_cast<float>(std::cos(step * chunkSize));
+
+        // Left feeds the even lines and right the odd ones; the outputs read two
+        // different Hadamard rows, which keeps the channels decorrelated.
+        const auto sign = hadamardSign(numLines - 1, i / 2);
+        line.injectLeft = (i % 2 == 0) ? sign * injection : 0.0f;
+        line.injectRight = (i % 2 == 1) ? sign * injection : 0.0f;
+        line.tapLeft = hadamardSign(1, i);
+        line.tapRight = hadamardSign(2, i);
+    }
+
+    updateTargets();
+}
+
+void NebulaReverb::updateTargets() noexcept
+{
+    const auto freeze = parameters.freeze;
+    const auto horizon = juce::jlimit(0.0f, 1.0f, parameters.horizon);
+    const auto width = juce::jlimit(0.0f, 1.0f, parameters.width);
+
+    damping.target = freeze ? 0.0f : juce::jlimit(0.0f, 1.0f, parameters.damping) * dampingScale;
+    inputGain.target = freeze ? 0.0f : 1.0f;
+    modulation.target = freeze ? 0.0f : modulationDepth;
+    wet1.target = wetScale * 0.5f * (1.0f + width);
+    wet2.target = wetScale * 0.5f * (1.0f - width);
+
+    // The Hadamard butterflies are left unnormalised; their 1 / sqrt(groups) is folded in here.
+    const auto hadamardScale = 1.0f / std::sqrt(static_cast<float>(numLines / householderSize));
+    const auto passFeedback = minimumFeedback + feedbackRange * horizon;
+    const auto referenceLoop = static_cast<float>(referenceLoopSeconds * sampleRate);
+
+    for (int i = 0; i < numLines; ++i)
+    {
+        auto& line = lines[static_cast<size_t>(i)];
+        line.targetFeedbackGain = hadamardScale * (freeze ? 1.0f : std::pow(passFeedback, line.baseDelay / referenceLoop));
+    }
+}
+
+double NebulaReverb::getTailSeconds(float inputPeak, float threshold) const noexcept
+{
+    if (parameters.freeze)
+        return std::numeric_limits<double>::infinity();
+
+    // Every line decays by passFeedback per reference loop. A burst can at worst come
+    // back out of every tap at once, so the starting level counts all of them.
+    const auto passFeedback = static_cast<double>(minimumFeedback + feedbackRange * juce::jlimit(0.0f, 1.0f, parameters.horizon));
+    const auto level = static_cast<double>(inputPeak) * wetScale * numLines;
+    if (level <= threshold)
+        return longestLineSeconds;
+
+    return longestLineSeconds + referenceLoopSeconds * std::ceil(std::log(threshold / level) / std::log(passFeedback));
+}
+
+void NebulaReverb::process(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto numChannels = block.getNumChannels();
+    const auto numSamples = static_cast<int>(block.getNumSamples());
+    if (numChannels == 0 || numSamples == 0 || delayMemory.empty())
+        return;
+
+    auto* left = block.getChannelPointer(0);
+    auto* right = numChannels > 1 ? block.getChannelPointer(1) : nullptr;
+
+    for (int start = 0; start < numSamples; start += chunkSize)
+    {
+        const auto count = juce::jmin(chunkSize, numSamples - start);
+        const auto progress = static_cast<float>(start + count) / static_cast<float>(numSamples);
+        processChunk(left + start, right != nullptr ? right + start : left + start, count, progress);
+
+        auto& wetLeft = wetScratch[0];
+        auto& wetRight = wetScratch[1];
+        const auto w1 = wet1.at(progress);
+        const auto w2 = wet2.at(progress);
+
+        if (right != nullptr)
+        {
+            juce::FloatVectorOperations::copyWithMultiply(left + start, wetLeft, w1, count);
+            juce::FloatVectorOperations::addWithMultiply(left + start, wetRight, w2, count);
+            juce::FloatVectorOperations::copyWithMultiply(right + start, wetRight, w1, count);
+            juce::FloatVectorOperations::addWithMultiply(right + start, wetLeft, w2, count);
+        }
+        else
+        {
+            const auto monoGain = 0.5f * (w1 + w2);
+            juce::FloatVectorOperations::copyWithMultiply(left + start, wetLeft, monoGain, count);
+            juce::FloatVectorOperations::addWithMultiply(left + start, wetRight, monoGain, count);
+        }
+    }
+
+    for (auto* ramp : { &damping, &inputGain, &modulation, &wet1, &wet2 })
+        ramp->start = ramp->target;
+    for (int i = 0; i < numLines; ++i)
+        lines[static_cast<size_t>(i)].feedbackGain = lines[static_cast<size_t>(i)].targetFeedbackGain;
+
+    for (size_t channel = 2; channel < numChannels; ++channel)
+        juce::FloatVectorOperations::clear(block.getChannelPointer(channel), numSamples);
+}
+
+void NebulaReverb::processChunk(const float* inLeft, const float* inRight, int numSamples, float progress) noexcept
+{
+    const auto dampingCoefficient = damping.at(progress);
+    const auto depth = modulation.at(progress);
+
+    auto* wetLeft = wetScratch[0];
+    auto* wetRight = wetScratch[1];
+
+    for (int i = 0; i < numLines; ++i)
+        readLine(i, lineSignals[i], numSamples, depth);
+
+    // The damping filters are the only recursive stage. Stepping all lines together
+    // keeps their independent recursions in flight at once.
+    float states[maxLines];
+    for (int i = 0; i < numLines; ++i)
+        states[i] = lines[static_cast<size_t>(i)].dampingState;
+
+    for (int t = 0; t < numSamples; ++t)
+        for (int i = 0; i < numLines; ++i)
+        {
+            const auto x = lineSignals[i][t];
+            states[i] = x + (states[i] - x) * dampingCoefficient;
+            lineSignals[i][t] = states[i];
+        }
+
+    const auto numVectors = (numSamples + laneWidth - 1) / laneWidth;
+    const auto numGroups = numLines / householderSize;
+
+    // Output taps, loss gains and the Householder reflection within each group of
+    // four, x - (2 / 4) * sum(x), in one pass. The taps see the damped signal before
+    // the loss gain, as the Freeverb combs did. Partial chunks run to the end of the
+    // last register; those extra lanes are never written back.
+    for (int group = 0; group < numGroups; ++group)
+    {
+        float* rows[householderSize];
+        FloatVector gains[householderSize];
+        float tapsLeft[householderSize];
+        float tapsRight[householderSize];
+
+        for (int k = 0; k < householderSize; ++k)
+        {
+            const auto index = group * householderSize + k;
+            auto& line = lines[static_cast<size_t>(index)];
+            line.dampingState = states[index];
+            rows[k] = lineSignals[index];
+            gains[k] = FloatVector::expand(line.feedbackGain + (line.targetFeedbackGain - line.feedbackGain) * progress);
+            tapsLeft[k] = line.tapLeft;
+            tapsRight[k] = line.tapRight;
+        }
+
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const auto offset = v * laneWidth;
+            auto wetLeftVector = group == 0 ? FloatVector::expand(0.0f) : FloatVector::fromRawArray(wetLeft + offset);
+            auto wetRightVector = group == 0 ? FloatVector::expand(0.0f) : FloatVector::fromRawArray(wetRight + offset);
+            FloatVector x[householderSize];
+            auto sum = FloatVector::expand(0.0f);
+
+            for (int k = 0; k < householderSize; ++k)
+            {
+                const auto damped = FloatVector::fromRawArray(rows[k] + offset);
+                wetLeftVector += damped * tapsLeft[k];
+                wetRightVector += damped * tapsRight[k];
+                x[k] = damped * gains[k];
+                sum += x[k];
+            }
+
+            sum *= 2.0f / static_cast<float>(householderSize);
+            for (int k = 0; k < householderSize; ++k)
+                (x[k] - sum).copyToRawArray(rows[k] + offset);
+
+            wetLeftVector.copyToRawArray(wetLeft + offset);
+            wetRightVector.copyToRawArray(wetRight + offset);
+        }
+    }
+
+    const auto gainIn = inputGain.at(progress);
+    juce::FloatVectorOperations::copyWithMultiply(injectScratch[0], inLeft, gainIn, numSamples);
+    juce::FloatVectorOperations::copyWithMultiply(injectScratch[1], inRight, gainIn, numSamples);
+    juce::FloatVectorOperations::clear(injectScratch[0] + numSamples, numVectors * laneWidth - numSamples);
+    juce::FloatVectorOperations::clear(injectScratch[1] + numSamples, numVectors * laneWidth - numSamples);
+
+    // Hadamard butterflies across the groups, then the input injection, one column
+    // of lines at a time.
+    for (int column = 0; column < householderSize; ++column)
+    {
+        for (int v = 0; v < numVectors; ++v)
+        {
+            const auto offset = v * laneWidth;
+            FloatVector x[maxLines / householderSize];
+            for (int group = 0; group < numGroups; ++group)
+                x[group] = FloatVector::fromRawArray(lineSignals[group * householderSize + column] + offset);
+
+            for (int span = 1; span < numGroups; span *= 2)
+                for (int first = 0; first < numGroups; first += 2 * span)
+                    for (int g = first; g < first + span; ++g)
+                    {
+                        const auto a = x[g];
+                        const auto b = x[g + span];
+                        x[g] = a + b;
+                        x[g + span] = a - b;
+                    }
+
+            const auto inLeftVector = FloatVector::fromRawArray(injectScratch[0] + offset);
+            const auto inRightVector = FloatVector::fromRawArray(injectScratch[1] + offset);
+
+            for (int group = 0; group < numGroups; ++group)
+            {
+                const auto index = group * householderSize + column;
+                const auto& line = lines[static_cast<size_t>(index)];
+                (x[group] + inLeftVector * line.injectLeft + inRightVector * line.injectRight)
+                    .copyToRawArray(lineSignals[index] + offset);
+            }
+        }
+    }
+
+    for (int i = 0; i < numLines; ++i)
+        writeLine(i, lineSignals[i], numSamples);
+
+    writePosition = (writePosition + numSamples) & lineMask;
+}
+
+void NebulaReverb::readLine(int index, float* destination, int numSamples, float depth) noexcept
+{
+    auto& line = lines[static_cast<size_t>(index)];
+
+    // Advance the quadrature oscillator across the chunk by rotation. Only a short
+    // final chunk needs its own angle.
+    auto rotateSin = line.chunkRotateSin;
+    auto rotateCos = line.chunkRotateCos;
+    if (numSamples != chunkSize)
+    {
+        rotateSin = std::sin(line.lfoStep * static_cast<float>(numSamples));
+        rotateCos = std::cos(line.lfoStep * static_cast<float>(numSamples));
+    }
+
+    const auto startSin = line.lfoSin;
+    const auto endSin = startSin * rotateCos + line.lfoCos * rotateSin;
+    const auto endCos = line.lfoCos * rotateCos - startSin * rotateSin;
+
+    // One Newton step towards unit magnitude keeps rounding from drifting the amplitude.
+    const auto correction = 1.5f - 0.5f * (endSin * endSin + endCos * endCos);
+    line.lfoSin = endSin * correction;
+    line.lfoCos = endCos * correction;
+
+    // Within a chunk the modulation is a straight line; at well under 1 Hz the
+    // curvature over 64 samples is far below a thousandth of a sample.
+    const auto startDelay = line.baseDelay + (startSin + 1.0f) * depth;
+    const auto delayStep = (line.baseDelay + (endSin + 1.0f) * depth - startDelay) / static_cast<float>(numSamples);
+
+    const auto* memory = delayMemory.data() + static_cast<size_t>(index * lineStride);
+    const auto whole = static_cast<int>(startDelay);
+    const auto lastDelay = startDelay + delayStep * static_cast<float>(numSamples - 1);
+
+    if (static_cast<int>(lastDelay) == whole)
+    {
+        // The integer delay holds across the chunk, so the taps are one contiguous
+        // run; run[t] is the older neighbour of output t and run[t + 1] the newer.
+        // Only a run that wraps around the ring is gathered into scratch first.
+        const auto first = (writePosition - whole - 1) & lineMask;
+        const auto runLength = numSamples + 1;
+        const auto* run = memory + first;
+
+        if (first + runLength > lineStride)
+        {
+            const auto beforeWrap = lineStride - first;
+            juce::FloatVectorOperations::copy(rawRead, memory + first, beforeWrap);
+            juce::FloatVectorOperations::copy(rawRead + beforeWrap, memory, runLength - beforeWrap);
+            run = rawRead;
+        }
+
+        const auto startFraction = startDelay - static_cast<float>(whole);
+        for (int t = 0; t < numSamples; ++t)
+        {
+            const auto fraction = startFraction + delayStep * static_cast<float>(t);
+            destination[t] = run[t + 1] + (run[t] - run[t + 1]) * fraction;
+        }
+        return;
+    }
+
+    for (int t = 0; t < numSamples; ++t)
+    {
+        const auto delay = startDelay + delayStep * static_cast<float>(t);
+        const auto tapWhole = static_cast<int>(delay);
+        const auto fraction = delay - static_cast<float>(tapWhole);
+        const auto newer = memory[(writePosition + t - tapWhole) & lineMask];
+        const auto older = memory[(writePosition + t - tapWhole - 1) & lineMask];
+        destination[t] = newer + (older - newer) * fraction;
+    }
+}
+
+void NebulaReverb::writeLine(int index, const float* source, int numSamples) noexcept
+{
+    auto* memory = delayMemory.data() + static_cast<size_t>(index * lineStride);
+    const auto beforeWrap = juce::jmin(numSamples, lineStride - writePosition);
+    juce::FloatVectorOperations::copy(memory + writePosition, source, beforeWrap);
+    if (beforeWrap < numSamples)
+        juce::FloatVectorOperations::copy(memory, source + beforeWrap, numSamples - beforeWrap);
+}
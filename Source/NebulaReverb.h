@@ -0,0 +1,116 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <vector>
+
+// Nebula reverb: a feedback delay network of 8 or 16 modulated delay lines. Each line
+// has a one-pole damping filter and a loss gain derived from its length, so every line
+// decays at the same rate. The feedback matrix is a 4x4 Householder reflection within
+// each group of four lines, followed by a Hadamard butterfly across the groups. That
+// product is orthogonal and all of its entries have equal magnitude, so energy spreads
+// evenly over every line without a full matrix-vector product.
+//
+// The shortest line is far longer than a processing chunk, so nothing written during
+// a chunk is read back within it. Each chunk therefore runs line by line over all of
+// its samples, with the delay reads, mixing, injection and output taps as contiguous
+// vector operations. Only the damping filters recurse sample by sample.
+class NebulaReverb
+{
+public:
+    static constexpr int maxLines = 16;
+    static constexpr int numLineChoices = 2; // 8, 16 lines
+
+    struct Parameters
+    {
+        float horizon = 0.5f; // 0-1, maps to the decay time
+        float damping = 0.5f;
+        float width = 1.0f;
+        bool freeze = false;
+    };
+
+    // Message thread: allocates the delay memory for the largest network.
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    // Audio thread: changes glide over the next block. Freeze holds the tail and
+    // stops feeding new input into it.
+    void setParameters(const Parameters& newParameters) noexcept;
+
+    // Audio thread: 0 = 8 lines, 1 = 16 lines. Changing it clears the tail.
+    void setLineChoice(int choice) noexcept;
+    static constexpr int linesForChoice(int choice) noexcept { return 8 << choice; }
+    int getNumLines() const noexcept { return numLines; }
+
+    // Audio thread: how long the tail of an input with the given peak stays above the
+    // threshold at the current settings. Infinite while frozen.
+    double getTailSeconds(float inputPeak, float threshold) const noexcept;
+
+    // The network with its delay memory, as sized by prepare().
+    size_t getMemoryBytes() const noexcept { return sizeof(*this) + delayMemory.capacity() * sizeof(float); }
+
+    // Audio thread: replaces the first one or two channels with the wet signal and
+    // silences any others.
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+private:
+    using FloatVector = juce::dsp::SIMDRegister<float>;
+    static constexpr int laneWidth = static_cast<int>(FloatVector::SIMDNumElements);
+    static constexpr int chunkSize = 64;
+    static constexpr int householderSize = 4;
+
+    static_assert(chunkSize % laneWidth == 0, "Chunks must fill whole registers");
+
+    struct Line
+    {
+        float baseDelay = 0.0f;
+        float feedbackGain = 0.0f;
+        float targetFeedbackGain = 0.0f;
+        float dampingState = 0.0f;
+        float lfoSin = 0.0f;
+        float lfoCos = 1.0f;
+        float lfoStep = 0.0f;           // radians per sample
+        float chunkRotateSin = 0.0f;    // rotation by one full chunk
+        float chunkRotateCos = 1.0f;
+        float injectLeft = 0.0f;
+        float injectRight = 0.0f;
+        float tapLeft = 0.0f;
+        float tapRight = 0.0f;
+    };
+
+    // Block-rate settings glide from their value at the start of a block to the
+    // target, stepping once per chunk.
+    struct Ramp
+    {
+        float start = 0.0f;
+        float target = 0.0f;
+        float at(float progress) const noexcept { return start + (target - start) * progress; }
+    };
+
+    void configureLines() noexcept;
+    void updateTargets() noexcept;
+    void processChunk(const float* inLeft, const float* inRight, int numSamples, float progress) noexcept;
+    void readLine(int index, float* destination, int numSamples, float depth) noexcept;
+    void writeLine(int index, const float* source, int numSamples) noexcept;
+
+    double sampleRate = 44100.0;
+    Parameters parameters;
+    int lineChoice = 0;
+    int numLines = 8;
+    std::array<Line, maxLines> lines;
+
+    // Line i occupies [i * lineStride, (i + 1) * lineStride); lineStride is a power of two.
+    std::vector<float> delayMemory;
+    int lineStride = 0;
+    int lineMask = 0;
+    int writePosition = 0;
+    float modulationDepth = 0.0f;
+
+    Ramp damping, inputGain, modulation, wet1, wet2;
+
+    // Per-chunk scratch: one row per line, plus a gathered read, the input and the wet output.
+    alignas(64) float lineSignals[maxLines][chunkSize] {};
+    alignas(64) float rawRead[chunkSize + 1] {};
+    alignas(64) float injectScratch[2][chunkSize] {};
+    alignas(64) float wetScratch[2][chunkSize] {};
+};
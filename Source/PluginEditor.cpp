@@ -165,6 +165,11 @@ CosmicGrainDelayAudioProcessorEditor::CosmicGrainDelayAudioProcessorEditor(Cosmi
     : AudioProcessorEditor(&p), audioProcessor(p), parameters(vts)
 {
     initialiseControls();
+    audioProcessor.setGrainTelemetryEnabled(true);
+    latestSnapshot = &audioProcessor.acquireGrainVisualSnapshot();
+    frameTime = snapshotTime = juce::Time::getMillisecondCounterHiRes() * 0.001;
+    for (auto& bin : particleBins)
+        bin.reserve(latestSnapshot->grains.size());
     startTimerHz(30);
     setSize(1160, 840);
     generateStarField();
@@ -173,6 +178,8 @@ CosmicGrainDelayAudioProcessorEditor::CosmicGrainDelayAudioProcessorEditor(Cosmi
 CosmicGrainDelayAudioProcessorEditor::~CosmicGrainDelayAudioProcessorEditor()
 {
     stopTimer();
+    audioProcessor.setGrainTelemetryEnabled(false);
+    audioProcessor.setProfilingEnabled(false);
     setLookAndFeel(nullptr);
 }
 
@@ -208,6 +215,7 @@ void CosmicGrainDelayAudioProcessorEditor::initialiseControls()
     configureSlider(spreadSlider, "spread", "grain");
     configureSlider(grainScatterSlider, "grainScatter", "grain");
     configureSlider(grainEnvelopeSlider, "grainEnvelopeShape", "grain");
+    configureSlider(grainWindowSlider, "grainWindow", "grain");
     configureSlider(grainJitterSlider, "grainPitchJitter", "grain");
     configureSlider(delaySlider, "delayTime", "delay");
     configureSlider(delayDivisionSlider, "delayDivision", "delay");
@@ -236,6 +244,21 @@ void CosmicGrainDelayAudioProcessorEditor::initialiseControls()
         return 0.0;
     };
 
+    grainWindowSlider.setNumDecimalPlacesToDisplay(0);
+    grainWindowSlider.textFromValueFunction = [](double value)
+    {
+        auto index = juce::jlimit<int>(0, static_cast<int>(CosmicGrainDelayAudioProcessor::grainWindowLabels.size() - 1),
+            static_cast<int>(std::round(value)));
+        return juce::String(CosmicGrainDelayAudioProcessor::grainWindowLabels[static_cast<size_t>(index)]);
+    };
+    grainWindowSlider.valueFromTextFunction = [](const juce::String& text)
+    {
+        for (size_t i = 0; i < CosmicGrainDelayAudioProcessor::grainWindowLabels.size(); ++i)
+            if (text.equalsIgnoreCase(CosmicGrainDelayAudioProcessor::grainWindowLabels[i]))
+                return static_cast<double>(i);
+        return 0.0;
+    };
+
     auto setToggleText = [this](juce::ToggleButton& button, const juce::String& paramID, const juce::String& colourID)
     {
         if (auto* param = parameters.getParameter(paramID))
@@ -259,6 +282,26 @@ void CosmicGrainDelayAudioProcessorEditor::initialiseControls()
     setToggleText(distortionToggle, "distortionEnabled", "distortion");
     freezeButton.setLookAndFeel(&lookAndFeel);
     setToggleText(freezeButton, "reverbFreeze", "reverb");
+    setToggleText(convolveButton, "reverbConvolution", "reverb");
+
+    loadImpulseButton.setLookAndFeel(&lookAndFeel);
+    loadImpulseButton.onClick = [this] { chooseImpulseResponse(); };
+    addAndMakeVisible(loadImpulseButton);
+
+    impulseNameLabel.setJustificationType(juce::Justification::centred);
+    impulseNameLabel.setFont(juce::Font(12.0f, juce::Font::bold));
+    impulseNameLabel.setColour(juce::Label::textColourId, juce::Colours::white.withAlpha(0.85f));
+    addAndMakeVisible(impulseNameLabel);
+
+    // Not a parameter: profiling is a diagnostic that ends with the editor.
+    profileButton.setLookAndFeel(&lookAndFeel);
+    profileButton.setClickingTogglesState(true);
+    profileButton.onClick = [this]
+    {
+        audioProcessor.setProfilingEnabled(profileButton.getToggleState());
+        repaint(grainVisualiserBounds);
+    };
+    addAndMakeVisible(profileButton);
 
     grainSizeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(parameters, "grainSize", grainSizeSlider);
     densityAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(parameters, "density", densitySlider);
@@ -266,6 +309,7 @@ void CosmicGrainDelayAudioProcessorEditor::initialiseControls()
     spreadAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(parameters, "spread", spreadSlider);
     grainScatterAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(parameters, "grainScatter", grainScatterSlider);
     grainEnvelopeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(parameters, "grainEnvelopeShape", grainEnvelopeSlider);
+    grainWindowAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(parameters, "grainWindow", grainWindowSlider);
     grainJitterAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(parameters, "grainPitchJitter", grainJitterSlider);
     delayAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(parameters, "delayTime", delaySlider);
     delayDivisionAttachment = std::make_unique<juce::AudioProcessorValueTreeState::SliderAttachment>(parameters, "delayDivision", delayDivisionSlider);
@@ -281,6 +325,7 @@ void CosmicGrainDelayAudioProcessorEditor::initialiseControls()
     delaySyncAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(parameters, "delaySync", delaySyncButton);
     distortionAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(parameters, "distortionEnabled", distortionToggle);
     freezeAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(parameters, "reverbFreeze", freezeButton);
+    convolveAttachment = std::make_unique<juce::AudioProcessorValueTreeState::ButtonAttachment>(parameters, "reverbConvolution", convolveButton);
 
     delaySyncButton.onStateChange = [this]
     {
@@ -337,13 +382,51 @@ void CosmicGrainDelayAudioProcessorEditor::initialiseControls()
         updateDelayMode();
     };
 
+    // Horizon, Damping and Freeze shape the network only; the impulse response sets
+    // them in convolution mode.
+    auto setNetworkControlsEnabled = [this, findLabel](bool enabled)
+    {
+        for (auto* slider : { &reverbSizeSlider, &reverbDampingSlider })
+        {
+            slider->setEnabled(enabled);
+            slider->setAlpha(enabled ? 1.0f : 0.35f);
+            if (auto* label = findLabel(*slider))
+                label->setAlpha(enabled ? 1.0f : 0.35f);
+        }
+
+        freezeButton.setEnabled(enabled);
+        freezeButton.setAlpha(enabled ? 1.0f : 0.35f);
+        for (auto& pair : toggleLabelPairs)
+            if (pair.first == &freezeButton)
+                pair.second->setAlpha(enabled ? 1.0f : 0.35f);
+    };
+
     distortionToggle.onStateChange = [setDistortionEnabled, this]() mutable
     {
         setDistortionEnabled(distortionToggle.getToggleState());
     };
 
+    convolveButton.onStateChange = [setNetworkControlsEnabled, this]() mutable
+    {
+        setNetworkControlsEnabled(!convolveButton.getToggleState());
+    };
+
     updateDelayMode();
     setDistortionEnabled(distortionToggle.getToggleState());
+    setNetworkControlsEnabled(!convolveButton.getToggleState());
+}
+
+void CosmicGrainDelayAudioProcessorEditor::chooseImpulseResponse()
+{
+    impulseChooser = std::make_unique<juce::FileChooser>("Load an impulse response", audioProcessor.getImpulseResponseFile(),
+                                                         "*.wav;*.aif;*.aiff;*.flac");
+    impulseChooser->launchAsync(juce::FileBrowserComponent::openMode | juce::FileBrowserComponent::canSelectFiles,
+                                [this](const juce::FileChooser& chooser)
+                                {
+                                    const auto file = chooser.getResult();
+                                    if (file.existsAsFile())
+                                        audioProcessor.loadImpulseResponse(file);
+                                });
 }
 
 void CosmicGrainDelayAudioProcessorEditor::generateStarField()
@@ -363,27 +446,103 @@ void CosmicGrainDelayAudioProcessorEditor::generateStarField()
 
 void CosmicGrainDelayAudioProcessorEditor::paint(juce::Graphics& g)
 {
-    auto bounds = getLocalBounds().toFloat();
-    juce::ColourGradient spaceGradient(juce::Colour(0xff0d0221), bounds.getTopLeft(), juce::Colour(0xff1b1f3b), bounds.getBottomRight(), false);
-    spaceGradient.addColour(0.3, juce::Colour(0xff332e59));
-    spaceGradient.addColour(0.9, juce::Colour(0xff0f3057));
-    g.setGradientFill(spaceGradient);
-    g.fillRect(bounds);
+    const auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    if (backgroundLayer.isNull() || scale != layerScale)
+        rebuildLayers(scale);
+
+    const auto bounds = getLocalBounds().toFloat();
+    const auto clip = g.getClipBounds();
 
+    g.drawImage(backgroundLayer, bounds);
+
+    // Only the stars inside the area being repainted are drawn.
     for (auto& star : stars)
     {
+        if (!clip.intersects(getStarBounds(star)))
+            continue;
+
         auto twinkle = 0.5f + 0.5f * std::sin(star.phase);
         auto colour = juce::Colour::fromHSV(0.65f + 0.05f * twinkle, 0.6f, 0.9f, 0.6f + twinkle * 0.3f);
         g.setColour(colour);
         g.fillEllipse(star.position.x, star.position.y, star.radius, star.radius);
     }
 
-    auto glitchLayer = bounds.reduced(juce::jmap(std::sin(juce::Time::getMillisecondCounter() * 0.002f), -4.0f, 4.0f));
+    g.drawImage(decorationLayer, bounds);
+
+    if (!grainVisualiserBounds.isEmpty() && clip.intersects(grainVisualiserBounds))
+        paintVisualiser(g);
+}
+
+void CosmicGrainDelayAudioProcessorEditor::rebuildLayers(float scale)
+{
+    layerScale = scale;
+    const auto width = juce::jmax(1, juce::roundToInt(static_cast<float>(getWidth()) * scale));
+    const auto height = juce::jmax(1, juce::roundToInt(static_cast<float>(getHeight()) * scale));
+    const auto transform = juce::AffineTransform::scale(scale);
+
+    backgroundLayer = juce::Image(juce::Image::RGB, width, height, false);
+    {
+        juce::Graphics g(backgroundLayer);
+        g.addTransform(transform);
+        paintBackgroundLayer(g);
+    }
+
+    decorationLayer = juce::Image(juce::Image::ARGB, width, height, true);
+    {
+        juce::Graphics g(decorationLayer);
+        g.addTransform(transform);
+        paintDecorationLayer(g);
+    }
+
+    rebuildSpriteAtlas(scale);
+}
+
+void CosmicGrainDelayAudioProcessorEditor::rebuildSpriteAtlas(float scale)
+{
+    // One cell per pitch hue and particle size, each holding an opaque disc; a grain's
+    // energy becomes the opacity it is drawn with.
+    const auto cell = juce::roundToInt(spriteCellSize * scale);
+    spriteAtlas = juce::Image(juce::Image::ARGB, cell * spriteHues, cell * spriteSizes, true);
+    sprites.clear();
+
+    juce::Graphics g(spriteAtlas);
+    for (int size = 0; size < spriteSizes; ++size)
+    {
+        for (int hue = 0; hue < spriteHues; ++hue)
+        {
+            const auto area = juce::Rectangle<int>(hue * cell, size * cell, cell, cell);
+            const auto diameter = spriteDiameter(size) * scale;
+            g.setColour(juce::Colour::fromHSV(static_cast<float>(hue) / static_cast<float>(spriteHues - 1), 0.6f, 0.9f, 1.0f));
+            g.fillEllipse(area.toFloat().withSizeKeepingCentre(diameter, diameter));
+            sprites.push_back(spriteAtlas.getClippedImage(area));
+        }
+    }
+}
+
+float CosmicGrainDelayAudioProcessorEditor::spriteDiameter(int sizeBucket) noexcept
+{
+    return minSpriteDiameter + (maxSpriteDiameter - minSpriteDiameter) * static_cast<float>(sizeBucket) / static_cast<float>(spriteSizes - 1);
+}
+
+void CosmicGrainDelayAudioProcessorEditor::paintBackgroundLayer(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+    juce::ColourGradient spaceGradient(juce::Colour(0xff0d0221), bounds.getTopLeft(), juce::Colour(0xff1b1f3b), bounds.getBottomRight(), false);
+    spaceGradient.addColour(0.3, juce::Colour(0xff332e59));
+    spaceGradient.addColour(0.9, juce::Colour(0xff0f3057));
+    g.setGradientFill(spaceGradient);
+    g.fillRect(bounds);
+}
+
+void CosmicGrainDelayAudioProcessorEditor::paintDecorationLayer(juce::Graphics& g)
+{
+    auto bounds = getLocalBounds().toFloat();
+
     g.setColour(glitchColour);
     for (int i = 0; i < 40; ++i)
     {
-        auto lineY = random.nextFloat() * glitchLayer.getHeight() + glitchLayer.getY();
-        auto lineX = glitchLayer.getX() + random.nextFloat() * glitchLayer.getWidth();
+        auto lineY = random.nextFloat() * bounds.getHeight() + bounds.getY();
+        auto lineX = bounds.getX() + random.nextFloat() * bounds.getWidth();
         auto length = random.nextFloat() * 120.0f;
         g.fillRect(juce::Rectangle<float>(lineX, lineY, length, 1.0f));
     }
@@ -405,73 +564,196 @@ void CosmicGrainDelayAudioProcessorEditor::paint(juce::Graphics& g)
         g.fillRoundedRectangle(visualiser, 18.0f);
         g.setColour(juce::Colours::white.withAlpha(0.3f));
         g.drawRoundedRectangle(visualiser, 18.0f, 1.6f);
+    }
+
+    g.setColour(juce::Colours::white.withAlpha(0.15f));
+    g.drawRoundedRectangle(getLocalBounds().reduced(12).toFloat(), 12.0f, 1.5f);
+}
+
+void CosmicGrainDelayAudioProcessorEditor::paintVisualiser(juce::Graphics& g)
+{
+    // Everything animated stays inside the visualiser, which is all a vblank repaints.
+    const juce::Graphics::ScopedSaveState savedState(g);
+    g.reduceClipRegion(grainVisualiserBounds);
+    auto visualiser = grainVisualiserBounds.toFloat();
+
+    auto dashedColour = juce::Colours::white.withAlpha(0.15f);
+    g.setColour(dashedColour);
+    for (int i = 0; i < 6; ++i)
+    {
+        auto orbitPhase = static_cast<double>(i) + frameTime;
+        auto wave = static_cast<float>(0.5 + 0.5 * std::sin(orbitPhase));
+        g.setColour(dashedColour.withAlpha(wave * 0.35f));
+        auto orbitRadius = visualiser.getWidth() * (0.18f + 0.12f * static_cast<float>(i));
+        auto orbitBounds = juce::Rectangle<float>(orbitRadius, orbitRadius);
+        orbitBounds = orbitBounds.withCentre(visualiser.getCentre());
+        g.drawEllipse(orbitBounds, 0.8f);
+    }
+
+    auto centre = visualiser.getCentre();
+    auto maxRadius = juce::jmin(visualiser.getWidth(), visualiser.getHeight()) * 0.45f;
+    auto innerRadius = juce::jmin(visualiser.getWidth(), visualiser.getHeight()) * 0.18f;
+
+    const auto& snapshot = *latestSnapshot;
+    if (snapshot.grainCount == 0)
+    {
+        g.setColour(juce::Colours::white.withAlpha(0.6f));
+        g.setFont(juce::Font(14.0f, juce::Font::italic));
+        g.drawText("waiting for grains", grainVisualiserBounds, juce::Justification::centred);
+    }
+    else
+    {
+        const auto sinceSnapshot = static_cast<float>(frameTime - snapshotTime);
+        const auto spin = static_cast<float>(frameTime * 0.35);
+
+        // Grains are binned by energy, so each bin costs one stroke for all of its
+        // tails and one opacity change for all of its sprites.
+        for (int bin = 0; bin < opacityLevels; ++bin)
+        {
+            tailPaths[static_cast<size_t>(bin)].clear();
+            particleBins[static_cast<size_t>(bin)].clear();
+        }
 
-        auto dashedColour = juce::Colours::white.withAlpha(0.15f);
-        g.setColour(dashedColour);
-        for (int i = 0; i < 6; ++i)
+        for (size_t i = 0; i < snapshot.grainCount; ++i)
         {
-            auto orbitPhase = static_cast<double>(i) + juce::Time::getMillisecondCounterHiRes() * 0.001;
-            auto wave = static_cast<float>(0.5 + 0.5 * std::sin(orbitPhase));
-            g.setColour(dashedColour.withAlpha(wave * 0.35f));
-            auto orbitRadius = visualiser.getWidth() * (0.18f + 0.12f * static_cast<float>(i));
-            auto orbitBounds = juce::Rectangle<float>(orbitRadius, orbitRadius);
-            orbitBounds = orbitBounds.withCentre(visualiser.getCentre());
-            g.drawEllipse(orbitBounds, 0.8f);
+            const auto& grain = snapshot.grains[i];
+
+            auto progress = juce::jlimit(0.0f, 1.0f, grain.age + sinceSnapshot / juce::jmax(0.001f, grain.durationSeconds));
+            auto pitchHue = juce::jlimit(0.0f, 1.0f, 0.55f + grain.pitchSemitone * 0.015f);
+            auto size = juce::jlimit(minSpriteDiameter, maxSpriteDiameter, 8.0f + grain.durationSeconds * 60.0f);
+            auto energy = juce::jlimit(0.2f, 1.0f, 0.3f + grain.envelope);
+
+            auto rotation = spin + grain.pan * juce::MathConstants<float>::twoPi;
+            auto radius = innerRadius + (maxRadius - innerRadius) * progress;
+            auto position = centre + juce::Point<float>(std::cos(rotation), std::sin(rotation)) * radius;
+
+            const auto bin = juce::jlimit(0, opacityLevels - 1, static_cast<int>((energy - 0.2f) / 0.8f * static_cast<float>(opacityLevels)));
+            const auto hueBucket = juce::roundToInt(pitchHue * static_cast<float>(spriteHues - 1));
+            const auto sizeBucket = juce::roundToInt((size - minSpriteDiameter) / (maxSpriteDiameter - minSpriteDiameter) * static_cast<float>(spriteSizes - 1));
+
+            auto& tails = tailPaths[static_cast<size_t>(bin)];
+            tails.startNewSubPath(centre);
+            tails.lineTo(position);
+            particleBins[static_cast<size_t>(bin)].push_back({ position, sizeBucket * spriteHues + hueBucket });
         }
 
-        auto centre = visualiser.getCentre();
-        auto maxRadius = juce::jmin(visualiser.getWidth(), visualiser.getHeight()) * 0.45f;
-        auto innerRadius = juce::jmin(visualiser.getWidth(), visualiser.getHeight()) * 0.18f;
-        auto now = juce::Time::getMillisecondCounterHiRes() * 0.001;
+        const auto binEnergy = [](int bin) { return 0.2f + 0.8f * (static_cast<float>(bin) + 0.5f) / static_cast<float>(opacityLevels); };
 
-        if (latestSnapshot.grainCount == 0)
+        for (int bin = 0; bin < opacityLevels; ++bin)
         {
-            g.setColour(juce::Colours::white.withAlpha(0.6f));
-            g.setFont(juce::Font(14.0f, juce::Font::italic));
-            g.drawText("waiting for grains", grainVisualiserBounds, juce::Justification::centred);
+            if (particleBins[static_cast<size_t>(bin)].empty())
+                continue;
+
+            g.setColour(juce::Colours::white.withAlpha(binEnergy(bin) * 0.6f));
+            g.strokePath(tailPaths[static_cast<size_t>(bin)], juce::PathStrokeType(1.0f));
         }
-        else
+
+        // Sprites are drawn at the display's pixel scale, so only the translation resamples.
+        const auto halfCell = spriteCellSize * 0.5f;
+        const auto toLogical = juce::AffineTransform::scale(1.0f / layerScale);
+
+        for (int bin = 0; bin < opacityLevels; ++bin)
         {
-            auto tailColour = juce::Colours::white.withAlpha(0.2f);
-            for (size_t i = 0; i < latestSnapshot.grainCount; ++i)
-            {
-                const auto& grain = latestSnapshot.grains[i];
+            const auto& particles = particleBins[static_cast<size_t>(bin)];
+            if (particles.empty())
+                continue;
+
+            g.setOpacity(binEnergy(bin));
+            for (const auto& particle : particles)
+                g.drawImageTransformed(sprites[static_cast<size_t>(particle.sprite)],
+                                       toLogical.translated(particle.position.x - halfCell, particle.position.y - halfCell));
+        }
+
+        g.setColour(juce::Colours::white.withAlpha(0.55f));
+        g.setFont(juce::Font(12.0f, juce::Font::plain));
+        juce::String telemetry;
+        telemetry << juce::String(snapshot.activeGrains) << " grains   |   "
+                  << juce::String(juce::roundToInt(snapshot.spawnRatePerSecond)) << " grains/sec   |   "
+                  << juce::String(snapshot.delayTimeMs, 1) << " ms delay   |   "
+                  << "cap " << juce::String(snapshot.grainCapacity) << " @ "
+                  << juce::String(juce::roundToInt(snapshot.cpuLoad * 100.0f)) << "% budget   |   "
+                  << juce::String(static_cast<juce::int64>(snapshot.grainsStolen)) << " stolen   |   "
+                  << juce::String(static_cast<juce::int64>(snapshot.grainsDropped)) << " dropped";
+        g.drawFittedText(telemetry, grainVisualiserBounds.reduced(12, 8).withTrimmedRight(profileButton.getWidth() + 12),
+                         juce::Justification::topLeft, 1);
+    }
 
-                auto progress = juce::jlimit(0.0f, 1.0f, grain.age);
-                auto pitchHue = juce::jlimit(0.0f, 1.0f, 0.55f + grain.pitchSemitone * 0.015f);
-                auto size = juce::jlimit(6.0f, 20.0f, 8.0f + grain.durationSeconds * 60.0f);
-                auto energy = juce::jlimit(0.2f, 1.0f, 0.3f + grain.envelope);
+    if (profileButton.getToggleState() && latestProfile != nullptr)
+        paintProfileOverlay(g);
+}
+
+void CosmicGrainDelayAudioProcessorEditor::paintProfileOverlay(juce::Graphics& g)
+{
+    const auto& profile = *latestProfile;
+    auto panel = grainVisualiserBounds.reduced(12).withTrimmedTop(24);
+    panel = panel.removeFromRight(juce::jmin(300, panel.getWidth()));
 
-                auto rotation = static_cast<float>(now * 0.35) + grain.pan * juce::MathConstants<float>::twoPi;
-                auto radius = innerRadius + (maxRadius - innerRadius) * progress;
-                auto position = centre + juce::Point<float>(std::cos(rotation), std::sin(rotation)) * radius;
+    g.setColour(juce::Colour(0xd1060818));
+    g.fillRoundedRectangle(panel.toFloat(), 6.0f);
+    g.setColour(juce::Colours::white.withAlpha(0.25f));
+    g.drawRoundedRectangle(panel.toFloat(), 6.0f, 1.0f);
 
-                auto particleColour = juce::Colour::fromHSV(pitchHue, 0.6f, 0.9f, energy);
-                g.setColour(tailColour.withAlpha(energy * 0.6f));
-                g.drawLine({ centre, position }, 1.0f);
+    auto area = panel.reduced(10, 6);
+    const auto rowHeight = 16;
+    const auto textColour = juce::Colours::white.withAlpha(0.8f);
+    g.setFont(juce::Font(juce::Font::getDefaultMonospacedFontName(), 11.0f, juce::Font::plain));
 
-                g.setColour(particleColour);
-                g.fillEllipse({ position.x - size * 0.5f, position.y - size * 0.5f, size, size });
-            }
+    auto drawRow = [&](const juce::String& text)
+    {
+        g.setColour(textColour);
+        g.drawText(text, area.removeFromTop(rowHeight), juce::Justification::centredLeft, false);
+    };
 
-            g.setColour(juce::Colours::white.withAlpha(0.55f));
-            g.setFont(juce::Font(12.0f, juce::Font::plain));
-            juce::String telemetry;
-            telemetry << juce::String(latestSnapshot.activeGrains) << " grains   |   "
-                      << juce::String(juce::roundToInt(latestSnapshot.spawnRatePerSecond)) << " grains/sec   |   "
-                      << juce::String(latestSnapshot.delayTimeMs, 1) << " ms delay";
-            g.drawFittedText(telemetry, grainVisualiserBounds.reduced(12, 8), juce::Justification::topLeft, 1);
+    drawRow(juce::String("stage    mean    p99   peak us"));
+
+    // Each stage's rolling histogram sits to the right of its numbers, one bar per
+    // power-of-two bin, scaled to the window.
+    const auto window = juce::jmax(1u, profile.blocksInWindow);
+    for (size_t stage = 0; stage < StageProfiler::numStages; ++stage)
+    {
+        const auto& stats = profile.stages[stage];
+        auto row = area.removeFromTop(rowHeight);
+        auto bars = row.removeFromRight(StageProfiler::numBins * 4).reduced(0, 2);
+
+        g.setColour(textColour);
+        g.drawText(juce::String(StageProfiler::stageNames[stage]).paddedRight(' ', 7)
+                       + juce::String(stats.meanMicros, 1).paddedLeft(' ', 7)
+                       + juce::String(juce::roundToInt(StageProfiler::getPercentileMicros(stats, profile.blocksInWindow, 0.99f))).paddedLeft(' ', 7)
+                       + juce::String(juce::roundToInt(stats.peakMicros)).paddedLeft(' ', 7),
+                   row, juce::Justification::centredLeft, false);
+
+        g.setColour(juce::Colour::fromHSV(0.55f - 0.12f * static_cast<float>(stage), 0.6f, 0.9f, 0.9f));
+        for (int bin = 0; bin < StageProfiler::numBins; ++bin)
+        {
+            const auto share = static_cast<float>(stats.histogram[static_cast<size_t>(bin)]) / static_cast<float>(window);
+            const auto height = share * static_cast<float>(bars.getHeight());
+            if (height > 0.0f)
+                g.fillRect(static_cast<float>(bars.getX() + bin * 4), static_cast<float>(bars.getBottom()) - juce::jmax(1.0f, height), 3.0f, juce::jmax(1.0f, height));
         }
     }
 
-    g.setColour(juce::Colours::white.withAlpha(0.15f));
-    g.drawRoundedRectangle(getLocalBounds().reduced(12).toFloat(), 12.0f, 1.5f);
+    const auto& governor = audioProcessor.getGrainGovernor();
+    const auto deadline = juce::jmax(1.0, profile.deadlineMicros);
+    area.removeFromTop(4);
+    drawRow("block " + juce::String(juce::roundToInt(profile.blockMicros)) + " of " + juce::String(juce::roundToInt(profile.deadlineMicros))
+            + " us (" + juce::String(profile.blockMicros / deadline * 100.0, 1) + "%)");
+    drawRow("pool  " + juce::String(static_cast<juce::int64>(profile.activeGrains)) + " / "
+            + juce::String(static_cast<juce::int64>(governor.getPublishedCapacity())) + " grains, "
+            + juce::String(static_cast<juce::int64>(governor.getCounters().dropped)) + " dropped");
+    drawRow("memory " + juce::String(static_cast<double>(audioProcessor.getMemoryFootprint()) / (1024.0 * 1024.0), 1) + " MB");
+}
+
+juce::Rectangle<int> CosmicGrainDelayAudioProcessorEditor::getStarBounds(const Star& star)
+{
+    return juce::Rectangle<float>(star.position.x, star.position.y, star.radius, star.radius).getSmallestIntegerContainer().expanded(1);
 }
 
 void CosmicGrainDelayAudioProcessorEditor::resized()
 {
     generateStarField();
     layoutControls();
+    backgroundLayer = {};
+    decorationLayer = {};
 }
 
 void CosmicGrainDelayAudioProcessorEditor::layoutControls()
@@ -574,7 +856,7 @@ void CosmicGrainDelayAudioProcessorEditor::layoutControls()
     fxColumn = fxColumn.reduced(8);
 
     layoutSliderGrid({ &grainSizeSlider, &densitySlider, &pitchSlider, &spreadSlider,
-                       &grainScatterSlider, &grainEnvelopeSlider, &grainJitterSlider, &grainWetSlider },
+                       &grainScatterSlider, &grainEnvelopeSlider, &grainWindowSlider, &grainJitterSlider, &grainWetSlider },
                      grainColumn, 2);
 
     auto timeArea = timeColumn;
@@ -599,19 +881,56 @@ void CosmicGrainDelayAudioProcessorEditor::layoutControls()
 
     fxArea.removeFromTop(20);
     auto freezeArea = fxArea.removeFromBottom(48);
-    layoutToggle(freezeButton, freezeArea);
+    const int freezeCellWidth = freezeArea.getWidth() / 3;
+    layoutToggle(freezeButton, freezeArea.removeFromLeft(freezeCellWidth));
+    layoutToggle(convolveButton, freezeArea.removeFromLeft(freezeCellWidth));
+    auto loadBounds = juce::Rectangle<int>(juce::jmin(freezeArea.getWidth(), 84), 26).withCentre(freezeArea.getCentre());
+    loadImpulseButton.setBounds(loadBounds);
+    impulseNameLabel.setBounds(freezeArea.withHeight(20).withY(loadBounds.getY() - 26));
     fxArea.removeFromBottom(8);
     layoutSliderGrid({ &reverbMixSlider, &reverbSizeSlider, &reverbDampingSlider, &reverbWidthSlider }, fxArea, 2);
+
+    profileButton.setBounds(grainVisualiserBounds.getRight() - 84, grainVisualiserBounds.getY() + 8, 72, 20);
 }
 
 void CosmicGrainDelayAudioProcessorEditor::timerCallback()
 {
-    latestSnapshot = audioProcessor.getGrainVisualSnapshot();
+    impulseNameLabel.setText(audioProcessor.hasImpulseResponse()
+                                 ? audioProcessor.getImpulseResponseFile().getFileNameWithoutExtension().toUpperCase()
+                                 : juce::String("NO IMPULSE"),
+                             juce::dontSendNotification);
+
     for (auto& star : stars)
     {
         star.phase += star.twinkleSpeed * 0.02f;
         if (star.phase > juce::MathConstants<float>::twoPi)
             star.phase -= juce::MathConstants<float>::twoPi;
     }
-    repaint();
+
+    // The static layers never change between resizes, so only a few stars at a time
+    // are repainted. Each star still updates several times a second.
+    for (size_t i = 0; i < stars.size() && i < starsRepaintedPerFrame; ++i)
+    {
+        nextTwinkleStar = (nextTwinkleStar + 1) % stars.size();
+        repaint(getStarBounds(stars[nextTwinkleStar]));
+    }
+}
+
+void CosmicGrainDelayAudioProcessorEditor::advanceFrame()
+{
+    frameTime = juce::Time::getMillisecondCounterHiRes() * 0.001;
+
+    // A new slot means the audio thread published since the last frame; grain ages are
+    // extrapolated from the moment it was picked up.
+    const auto* snapshot = &audioProcessor.acquireGrainVisualSnapshot();
+    if (snapshot != latestSnapshot)
+    {
+        latestSnapshot = snapshot;
+        snapshotTime = frameTime;
+    }
+
+    if (profileButton.getToggleState())
+        latestProfile = &audioProcessor.acquireProfile();
+
+    repaint(grainVisualiserBounds);
 }
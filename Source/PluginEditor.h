@@ -4,7 +4,9 @@
 #include <juce_gui_extra/juce_gui_extra.h>
 
 #include "GrainEngine.h"
+#include "StageProfiler.h"
 
+#include <array>
 #include <memory>
 #include <utility>
 #include <vector>
@@ -36,11 +38,24 @@ public:
     void paint(juce::Graphics&) override;
     void resized() override;
 
+    // Picks up the latest grain telemetry and repaints the visualiser. Runs on every
+    // display refresh; the paint benchmark calls it directly.
+    void advanceFrame();
+    juce::Rectangle<int> getVisualiserBounds() const noexcept { return grainVisualiserBounds; }
+
 private:
     void timerCallback() override;
     void initialiseControls();
     void layoutControls();
     void generateStarField();
+    void rebuildLayers(float scale);
+    void rebuildSpriteAtlas(float scale);
+    static float spriteDiameter(int sizeBucket) noexcept;
+    void paintBackgroundLayer(juce::Graphics&);
+    void paintDecorationLayer(juce::Graphics&);
+    void paintVisualiser(juce::Graphics&);
+    void paintProfileOverlay(juce::Graphics&);
+    void chooseImpulseResponse();
 
     CosmicGrainDelayAudioProcessor& audioProcessor;
     juce::AudioProcessorValueTreeState& parameters;
@@ -54,6 +69,7 @@ private:
     juce::Slider spreadSlider;
     juce::Slider grainScatterSlider;
     juce::Slider grainEnvelopeSlider;
+    juce::Slider grainWindowSlider;
     juce::Slider grainJitterSlider;
     juce::Slider delaySlider;
     juce::Slider delayDivisionSlider;
@@ -69,6 +85,11 @@ private:
     juce::ToggleButton delaySyncButton { "SYNC TO BPM" };
     juce::ToggleButton distortionToggle { "IGNITE METEOR BURN" };
     juce::ToggleButton freezeButton { "SPACE FREEZE" };
+    juce::ToggleButton convolveButton { "SPACE CONVOLVE" };
+    juce::TextButton loadImpulseButton { "LOAD IR" };
+    juce::TextButton profileButton { "PROFILE" };
+    juce::Label impulseNameLabel;
+    std::unique_ptr<juce::FileChooser> impulseChooser;
 
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> grainSizeAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> densityAttachment;
@@ -76,6 +97,7 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> spreadAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> grainScatterAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> grainEnvelopeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> grainWindowAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> grainJitterAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> delayAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::SliderAttachment> delayDivisionAttachment;
@@ -91,12 +113,19 @@ private:
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> delaySyncAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> distortionAttachment;
     std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> freezeAttachment;
+    std::unique_ptr<juce::AudioProcessorValueTreeState::ButtonAttachment> convolveAttachment;
 
     std::vector<std::unique_ptr<juce::Label>> sliderLabels;
     std::vector<std::pair<juce::Slider*, juce::Label*>> sliderLabelPairs;
     std::vector<std::unique_ptr<juce::Label>> toggleLabels;
     std::vector<std::pair<juce::ToggleButton*, juce::Label*>> toggleLabelPairs;
-    GrainEngine::VisualSnapshot latestSnapshot;
+    // Read in place; valid until the next acquire in advanceFrame().
+    const GrainEngine::VisualSnapshot* latestSnapshot = nullptr;
+    // Seconds on the hi-res clock: the current vblank, and when the snapshot arrived.
+    double frameTime = 0.0;
+    double snapshotTime = 0.0;
+    // Only acquired while the profiling overlay is shown.
+    const StageProfiler::Snapshot* latestProfile = nullptr;
 
     struct Star
     {
@@ -106,9 +135,42 @@ private:
         float phase = 0.0f;
     };
 
+    static juce::Rectangle<int> getStarBounds(const Star&);
+
     std::vector<Star> stars;
+    static constexpr size_t starsRepaintedPerFrame = 20;
+    size_t nextTwinkleStar = 0;
     juce::Colour glitchColour { juce::Colours::white.withAlpha(0.08f) };
     juce::Rectangle<int> grainVisualiserBounds {};
 
+    // Static layers at the display's pixel scale, rebuilt only on resize: the gradient,
+    // then the glitch lines, branding and frames that sit above the stars.
+    juce::Image backgroundLayer;
+    juce::Image decorationLayer;
+    float layerScale = 0.0f;
+
+    // Grain particles: pre-rendered discs, one per pitch hue and size, drawn in batches
+    // that share an opacity level.
+    static constexpr int spriteHues = 24;
+    static constexpr int spriteSizes = 8;
+    static constexpr int opacityLevels = 8;
+    static constexpr float spriteCellSize = 24.0f;
+    static constexpr float minSpriteDiameter = 6.0f;
+    static constexpr float maxSpriteDiameter = 20.0f;
+
+    struct Particle
+    {
+        juce::Point<float> position;
+        int sprite = 0;
+    };
+
+    juce::Image spriteAtlas;
+    std::vector<juce::Image> sprites;
+    std::array<juce::Path, opacityLevels> tailPaths;
+    std::array<std::vector<Particle>, opacityLevels> particleBins;
+
+    // Declared last so it detaches before anything advanceFrame() touches is destroyed.
+    juce::VBlankAttachment vBlankAttachment { this, [this] { advanceFrame(); } };
+
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CosmicGrainDelayAudioProcessorEditor)
 };
@@ -1,80 +1,310 @@
 #include "PluginProcessor.h"
 #include "PluginEditor.h"
+#include "RealtimeAllocationGuard.h"
 
 #include <cmath>
 
+namespace
+{
+const juce::Identifier impulseResponseProperty { "impulseResponse" };
+
+float toneToCutoff(float tone)
+{
+    return juce::jmap(juce::jlimit(0.0f, 1.0f, tone), 800.0f, 8000.0f);
+}
+
+float driveToGain(float drive)
+{
+    return juce::jmap(drive, 0.0f, 1.0f, 1.0f, 10.0f);
+}
+
+// Covers the oversampling filters and the tone filter ringing at its lowest cutoff.
+constexpr double distortionTailSeconds = 0.05;
+
+constexpr double smoothingSeconds = 0.02;
+
+// Indexed by ParameterSnapshot::Index.
+constexpr std::array parameterIds {
+    "grainSize",
+    "density",
+    "pitch",
+    "spread",
+    "grainScatter",
+    "grainEnvelopeShape",
+    "grainWindow",
+    "grainPitchJitter",
+    "feedback",
+    "grainWet",
+    "delayTime",
+    "delaySync",
+    "delayDivision",
+    "distortionEnabled",
+    "distortionDrive",
+    "distortionTone",
+    "distortionMix",
+    "distortionOversampling",
+    "reverbMix",
+    "reverbSize",
+    "reverbDamping",
+    "reverbWidth",
+    "reverbFreeze",
+    "reverbLines",
+    "reverbConvolution",
+    "multicoreRender",
+    "grainInterpolation",
+    "governorBudget",
+    "governorStealOldest",
+    "grainStereoLink"
+};
+
+template <bool ramping, typename Block>
+void blendChannel(float* dry, const float* wet, const Block& blend, int numSamples) noexcept
+{
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        const auto amount = blend.template at<ramping>(sample);
+        dry[sample] = dry[sample] * (1.0f - amount) + wet[sample] * amount;
+    }
+}
+
+// In single precision output and wetGrain are the same channel.
+template <bool mixRamps, bool wetRamps, typename SampleType, typename Block>
+void mixChannel(SampleType* output, const SampleType* dry, const float* wetGrain, const float* wetReverb,
+                const Block& mix, const Block& grainWet, int numSamples) noexcept
+{
+    for (int sample = 0; sample < numSamples; ++sample)
+    {
+        const auto reverbShare = mix.template at<mixRamps>(sample);
+        const auto wetShare = grainWet.template at<wetRamps>(sample);
+        auto combinedWet = wetGrain[sample] * (1.0f - reverbShare) + wetReverb[sample] * reverbShare;
+        output[sample] = dry[sample] * (1.0f - wetShare) + combinedWet * wetShare;
+    }
+}
+
+// Hosts keep rendering until the tail of a full-scale input has fallen by 60 dB, the
+// usual reverb-time convention. Stages sleep at a much lower threshold.
+constexpr float hostTailThreshold = 1.0e-3f;
+
+// The longest response Space Convolve loads. High feedback or Space Freeze would
+// otherwise have hosts render minutes of near-silence after a bounce.
+constexpr double maxHostTailSeconds = 30.0;
+}
+
 CosmicGrainDelayAudioProcessor::CosmicGrainDelayAudioProcessor()
     : AudioProcessor(BusesProperties().withInput("Input", juce::AudioChannelSet::stereo(), true)
                                         .withOutput("Output", juce::AudioChannelSet::stereo(), true)),
       parameters(*this, nullptr, "PARAMETERS", createParameterLayout())
 {
+    static_assert(parameterIds.size() == ParameterSnapshot::numParameters, "Parameter IDs must match the snapshot");
+    for (size_t index = 0; index < parameterIds.size(); ++index)
+    {
+        parameterHandles[index] = parameters.getRawParameterValue(parameterIds[index]);
+        jassert(parameterHandles[index] != nullptr);
+    }
+
+    backgroundThread.addTimeSliceClient(&grainEngine.getWindowBank());
+    backgroundThread.addTimeSliceClient(&convolution);
+    backgroundThread.startThread(juce::Thread::Priority::low);
+    parameters.addParameterListener("multicoreRender", this);
+
+   #if COSMIC_ENABLE_TRACING
+    grainEngine.setTraceRecorder(&tracer);
+   #endif
+}
+
+CosmicGrainDelayAudioProcessor::~CosmicGrainDelayAudioProcessor()
+{
+    parameters.removeParameterListener("multicoreRender", this);
+    cancelPendingUpdate();
+    backgroundThread.removeTimeSliceClient(&grainEngine.getWindowBank());
+    backgroundThread.removeTimeSliceClient(&convolution);
+    backgroundThread.stopThread(1000);
 }
 
 void CosmicGrainDelayAudioProcessor::prepareToPlay(double sampleRate, int samplesPerBlock)
 {
-    currentSampleRate = sampleRate;
-
-    juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32>(samplesPerBlock), static_cast<juce::uint32>(getTotalNumOutputChannels()) };
-    grainEngine.prepare(spec);
-    grainEngine.reset();
-    reverb.reset();
+    maxBlockSize = juce::jmax(1, samplesPerBlock);
+    readParameters(true);
+
+    const auto numInputs = juce::jmax(1, getTotalNumInputChannels());
+    const auto numChannels = juce::jmax(numInputs, getTotalNumOutputChannels());
+    const auto layout = getBusesLayout();
+    juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32>(maxBlockSize), static_cast<juce::uint32>(getTotalNumOutputChannels()) };
+    const auto useDoublePrecision = isUsingDoublePrecision();
+    grainEngine.prepare({ sampleRate, static_cast<juce::uint32>(maxBlockSize), static_cast<juce::uint32>(numInputs) },
+                        layout.getMainOutputChannelSet(), useDoublePrecision);
+    prepared = true;
+    updateRenderThreads();
+    reverb.prepare(spec);
+    convolution.prepare(spec);
 
-    distortionShaper.reset();
     distortionShaper.prepare(spec);
-    distortionShaper.functionToUse = [](float x) { return std::tanh(x); };
+    distortionShaper.reset();
+
+    distortionToneFilter.prepare(spec, toneToCutoff(parameterSnapshot[ParameterSnapshot::distortionTone]));
+    smoothing.prepare(sampleRate, maxBlockSize, smoothingSeconds);
+
+    // Every stage takes the current settings, then jumps to them instead of gliding
+    // from wherever the last session left them.
+    applyParameters();
+    resolvedDelayMs = resolveDelayMilliseconds(parameterSnapshot[ParameterSnapshot::delayTime],
+                                               parameterSnapshot.isOn(ParameterSnapshot::delaySync),
+                                               parameterSnapshot[ParameterSnapshot::delayDivision], 0.0);
+    grainEngine.setDelayTime(resolvedDelayMs);
+    grainEngine.reset();
+    smoothing.snapToTargets();
+
+    dryBuffer.setSize(useDoublePrecision ? 0 : numChannels, maxBlockSize);
+    doubleDryBuffer.setSize(useDoublePrecision ? numChannels : 0, maxBlockSize);
+    wetBuffer.setSize(useDoublePrecision ? numChannels : 0, maxBlockSize);
+    reverbBuffer.setSize(numChannels, maxBlockSize);
+    reverbBuffer.clear();
+    distortionBuffer.setSize(numChannels, maxBlockSize);
+    alignedDryBuffer.setSize(numChannels, maxBlockSize);
+
+    // A mono or stereo input on a wider bus is placed where its speakers would be.
+    const auto& panner = grainEngine.getPanner();
+    upmixDry = layout.getMainInputChannelSet() != layout.getMainOutputChannelSet();
+    numDryInputs = juce::jmin(numInputs, static_cast<int>(dryUpmixGains.size()));
+    for (int input = 0; upmixDry && input < numDryInputs; ++input)
+    {
+        const auto side = numDryInputs == 1 ? 0.0f : (input == 0 ? 1.0f : -1.0f);
+        panner.getGainsForAzimuth(side * juce::MathConstants<float>::pi / 6.0f, dryUpmixGains[static_cast<size_t>(input)].data());
+    }
+    numReverbChannels = panner.isAmbisonic() ? 1 : numChannels;
 
-    distortionToneFilter.reset();
-    distortionToneFilter.state = juce::dsp::IIR::Coefficients<float>::makeLowPass(sampleRate, 2000.0f);
-    distortionToneFilter.prepare(spec);
+    for (auto* activity : { &grainActivity, &distortionActivity, &reverbActivity })
+        activity->prepare(sampleRate);
+    estimatedConvolutionTail = convolution.getTailSeconds();
+    tailSeconds.store(estimateTailSeconds(), std::memory_order_relaxed);
 
-    distortionBuffer.setSize(static_cast<int>(getTotalNumOutputChannels()), samplesPerBlock);
+    profiler.prepare(sampleRate);
+    const auto bytesOf = [](const auto& buffer)
+    {
+        return static_cast<size_t>(buffer.getNumChannels()) * static_cast<size_t>(buffer.getNumSamples()) * sizeof(*buffer.getReadPointer(0));
+    };
+    const auto bufferBytes = bytesOf(dryBuffer) + bytesOf(doubleDryBuffer) + bytesOf(wetBuffer) + bytesOf(reverbBuffer)
+                           + bytesOf(distortionBuffer) + bytesOf(alignedDryBuffer);
+    preparedMemoryBytes.store(sizeof(*this) - sizeof(grainEngine) - sizeof(reverb) + grainEngine.getMemoryBytes()
+                                  + reverb.getMemoryBytes() + bufferBytes,
+                              std::memory_order_relaxed);
 }
 
 void CosmicGrainDelayAudioProcessor::releaseResources()
 {
+    prepared = false;
+    grainEngine.setRenderThreads(0);
+}
+
+void CosmicGrainDelayAudioProcessor::parameterChanged(const juce::String&, float)
+{
+    // Hosts may automate from the audio thread, which must not start or join threads.
+    triggerAsyncUpdate();
+}
+
+void CosmicGrainDelayAudioProcessor::handleAsyncUpdate()
+{
+    updateRenderThreads();
+}
+
+void CosmicGrainDelayAudioProcessor::updateRenderThreads()
+{
+    // Workers only run while Hyperdrive Cores is on, and even then help only once the
+    // cloud is dense enough. Swapping the pool is safe while blocks are rendering.
+    const auto enabled = parameters.getRawParameterValue("multicoreRender")->load() >= 0.5f;
+    grainEngine.setRenderThreads(prepared && enabled ? juce::jlimit(0, 3, juce::SystemStats::getNumPhysicalCpus() - 1) : 0);
+}
+
+bool CosmicGrainDelayAudioProcessor::isBusesLayoutSupported(const BusesLayout& layouts) const
+{
+    const auto input = layouts.getMainInputChannelSet();
+    const auto output = layouts.getMainOutputChannelSet();
+    if (output.size() < 2 || !GrainPanner::supportsLayout(output))
+        return false;
+
+    // Grains read every input channel separately, so an ambisonic input would be
+    // panned component by component; it is not accepted.
+    return input == juce::AudioChannelSet::mono() || input == juce::AudioChannelSet::stereo()
+        || (input == output && output.getAmbisonicOrder() < 0);
+}
+
+void CosmicGrainDelayAudioProcessor::audioWorkgroupContextChanged(const juce::AudioWorkgroup& workgroup)
+{
+    grainEngine.setAudioWorkgroup(workgroup);
 }
 
 void CosmicGrainDelayAudioProcessor::processBlock(juce::AudioBuffer<float>& buffer, juce::MidiBuffer& midiMessages)
 {
-    juce::ScopedNoDenormals noDenormals;
     juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
+
+void CosmicGrainDelayAudioProcessor::processBlock(juce::AudioBuffer<double>& buffer, juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused(midiMessages);
+    processSamples(buffer);
+}
+
+juce::AudioBuffer<float>& CosmicGrainDelayAudioProcessor::getSinglePrecisionWet(juce::AudioBuffer<float>& grains, int numSamples) noexcept
+{
+    juce::ignoreUnused(numSamples);
+    return grains;
+}
+
+juce::AudioBuffer<float>& CosmicGrainDelayAudioProcessor::getSinglePrecisionWet(juce::AudioBuffer<double>& grains, int numSamples) noexcept
+{
+    const auto numChannels = juce::jmin(grains.getNumChannels(), wetBuffer.getNumChannels());
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* source = grains.getReadPointer(channel);
+        auto* destination = wetBuffer.getWritePointer(channel);
+        for (int sample = 0; sample < numSamples; ++sample)
+            destination[sample] = static_cast<float>(source[sample]);
+    }
+    return wetBuffer;
+}
+
+template <typename SampleType>
+void CosmicGrainDelayAudioProcessor::processSamples(juce::AudioBuffer<SampleType>& buffer)
+{
+    const ScopedRealtimeAllocationGuard allocationGuard;
+    juce::ScopedNoDenormals noDenormals;
+
+    const auto numSamples = buffer.getNumSamples();
+    const auto numChannels = buffer.getNumChannels();
+
+    if (numSamples > maxBlockSize && maxBlockSize > 0)
+    {
+        // Some hosts exceed the block size announced in prepareToPlay. Split the call
+        // rather than growing the scratch buffers on the audio thread.
+        for (int start = 0; start < numSamples; start += maxBlockSize)
+        {
+            juce::AudioBuffer<SampleType> chunk(buffer.getArrayOfWritePointers(), numChannels, start,
+                                                juce::jmin(maxBlockSize, numSamples - start));
+            processSamples(chunk);
+        }
+        return;
+    }
+
+    profiler.beginBlock();
+    COSMIC_TRACE_SCOPE(&tracer, "processBlock");
 
     const auto totalNumInputChannels = getTotalNumInputChannels();
     const auto totalNumOutputChannels = getTotalNumOutputChannels();
 
     for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear(i, 0, buffer.getNumSamples());
-
-    auto* grainSize = parameters.getRawParameterValue("grainSize");
-    auto* density = parameters.getRawParameterValue("density");
-    auto* pitch = parameters.getRawParameterValue("pitch");
-    auto* spread = parameters.getRawParameterValue("spread");
-    auto* grainScatter = parameters.getRawParameterValue("grainScatter");
-    auto* grainEnvelopeShape = parameters.getRawParameterValue("grainEnvelopeShape");
-    auto* grainPitchJitter = parameters.getRawParameterValue("grainPitchJitter");
-    auto* feedback = parameters.getRawParameterValue("feedback");
-    auto* wet = parameters.getRawParameterValue("grainWet");
-    auto* delay = parameters.getRawParameterValue("delayTime");
-    auto* delaySync = parameters.getRawParameterValue("delaySync");
-    auto* delayDivision = parameters.getRawParameterValue("delayDivision");
-    auto* distortionEnabled = parameters.getRawParameterValue("distortionEnabled");
-    auto* distortionDrive = parameters.getRawParameterValue("distortionDrive");
-    auto* distortionTone = parameters.getRawParameterValue("distortionTone");
-    auto* distortionMix = parameters.getRawParameterValue("distortionMix");
-    auto* reverbMix = parameters.getRawParameterValue("reverbMix");
-    auto* reverbSize = parameters.getRawParameterValue("reverbSize");
-    auto* reverbDamping = parameters.getRawParameterValue("reverbDamping");
-    auto* reverbWidth = parameters.getRawParameterValue("reverbWidth");
-    auto* reverbFreeze = parameters.getRawParameterValue("reverbFreeze");
-
-    grainEngine.setGrainSize(*grainSize);
-    grainEngine.setDensity(*density);
-    grainEngine.setPitch(*pitch);
-    grainEngine.setSpread(*spread);
-    grainEngine.setScatter(*grainScatter);
-    grainEngine.setEnvelopeShape(*grainEnvelopeShape);
-    grainEngine.setPitchJitter(*grainPitchJitter);
-    grainEngine.setFeedback(*feedback);
+        buffer.clear(i, 0, numSamples);
+
+    readParameters(false);
+    const auto& p = parameterSnapshot;
+    using Parameter = ParameterSnapshot;
+
+    const auto previousDistortionGain = smoothing.getCurrent(smoothedDistortionGain);
+    applyParameters();
+    smoothing.advance(numSamples);
+
+    // Offline renders have no deadline, so they always get the full grain cloud.
+    grainEngine.getGovernor().setEnabled(!isNonRealtime());
 
     double bpm = 0.0;
     if (auto* head = getPlayHead())
@@ -82,47 +312,266 @@ void CosmicGrainDelayAudioProcessor::processBlock(juce::AudioBuffer<float>& buff
             if (auto bpmValue = position->getBpm())
                 bpm = *bpmValue;
 
-    const auto resolvedDelay = resolveDelayMilliseconds(*delay, *delaySync >= 0.5f, *delayDivision, bpm);
-    grainEngine.setDelayTime(resolvedDelay);
+    const auto delay = resolveDelayMilliseconds(p[Parameter::delayTime], p.isOn(Parameter::delaySync), p[Parameter::delayDivision], bpm);
+    const auto delayChanged = delay != resolvedDelayMs;
+    if (delayChanged)
+    {
+        resolvedDelayMs = delay;
+        grainEngine.setDelayTime(delay);
+    }
 
-    juce::AudioBuffer<float> dryBuffer;
-    dryBuffer.makeCopyOf(buffer);
+    auto& drySignal = getDryBuffer<SampleType>();
+    if (upmixDry)
+    {
+        for (int channel = 0; channel < juce::jmin(numChannels, GrainPanner::maxChannels); ++channel)
+        {
+            drySignal.clear(channel, 0, numSamples);
+            for (int input = 0; input < numDryInputs; ++input)
+                if (const auto gain = dryUpmixGains[static_cast<size_t>(input)][static_cast<size_t>(channel)]; gain != 0.0f)
+                    drySignal.addFrom(channel, 0, buffer, input, 0, numSamples, gain);
+        }
+    }
+    else
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            drySignal.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+    }
 
-    grainEngine.processBlock(buffer);
+    // Each stage runs from the first sample it has to; anything before that is silent.
+    grainActivity.setPeakGain(grainEngine.getPeakGain());
+    const auto grainStart = grainActivity.beginBlock(buffer.getArrayOfReadPointers(), numChannels, numSamples);
+    for (int channel = 0; channel < numChannels; ++channel)
+        buffer.clear(channel, 0, grainStart);
 
-    applyDistortion(buffer, *distortionDrive, *distortionTone, *distortionMix, *distortionEnabled >= 0.5f);
+    if (grainStart < numSamples)
+    {
+        const StageProfiler::Scope timing(profiler, StageProfiler::grains);
+        COSMIC_TRACE_SCOPE(&tracer, "grains");
+        juce::AudioBuffer<SampleType> awake(buffer.getArrayOfWritePointers(), numChannels, grainStart, numSamples - grainStart);
+        grainEngine.processBlock(awake);
+
+        grainActivity.setTailSeconds(grainEngine.getTailSeconds(grainActivity.getInputPeak() * grainEngine.getPeakGain(),
+                                                                StageActivity::silenceThreshold));
+        if (grainActivity.endBlock(buffer.getArrayOfReadPointers(), numChannels, numSamples))
+            grainEngine.clear();
+    }
 
-    reverbParams.roomSize = *reverbSize;
-    reverbParams.damping = *reverbDamping;
-    reverbParams.wetLevel = 1.0f;
-    reverbParams.dryLevel = 0.0f;
-    reverbParams.width = *reverbWidth;
-    reverbParams.freezeMode = (*reverbFreeze >= 0.5f) ? 1.0f : 0.0f;
-    reverb.setParameters(reverbParams);
+    auto& wet = getSinglePrecisionWet(buffer, numSamples);
 
-    juce::AudioBuffer<float> reverbBuffer;
-    reverbBuffer.makeCopyOf(buffer);
+    // The shaper keeps running while Burn Blend is up, even with Ignite off, so turning
+    // it on fades into a warm filter state; it stops once the blend has faded out.
+    const auto distortionRunning = p.isOn(Parameter::distortionEnabled) || p[Parameter::distortionMix] > 0.0f
+                                   || smoothing.isRamping(smoothedDistortionBlend);
+    distortionActivity.setPeakGain(distortionRunning ? juce::jmax(previousDistortionGain, smoothing.getCurrent(smoothedDistortionGain)) : 1.0f);
+    const auto distortionStart = distortionActivity.beginBlock(wet.getArrayOfReadPointers(), numChannels, numSamples);
 
-    juce::dsp::AudioBlock<float> reverbBlock(reverbBuffer);
-    juce::dsp::ProcessContextReplacing<float> reverbContext(reverbBlock);
-    reverb.process(reverbContext);
+    // A sleeping distortion stage passes its near-silent input through untouched.
+    if (distortionStart < numSamples)
+    {
+        const StageProfiler::Scope timing(profiler, StageProfiler::distortion);
+        COSMIC_TRACE_SCOPE(&tracer, "distortion");
+        juce::AudioBuffer<float> awake(wet.getArrayOfWritePointers(), numChannels, distortionStart, numSamples - distortionStart);
+        if (distortionRunning)
+            applyDistortion(awake, distortionStart);
+
+        distortionActivity.setTailSeconds(distortionTailSeconds);
+        if (distortionActivity.endBlock(wet.getArrayOfReadPointers(), numChannels, numSamples))
+        {
+            distortionShaper.reset();
+            distortionToneFilter.reset();
+        }
+    }
+
+    // Convolution falls back to the network until an impulse response has loaded.
+    const auto useConvolution = p.isOn(Parameter::reverbConvolution) && convolution.hasImpulseResponse();
+    const auto reverbSwitched = useConvolution != convolutionActive;
+    if (reverbSwitched)
+    {
+        // The reverb taking over starts from silence rather than replaying a stale tail.
+        if (useConvolution)
+            convolution.reset();
+        else
+            reverb.reset();
+        convolutionActive = useConvolution;
+        reverbActivity.reset();
+    }
+
+    // Channels past numReverbChannels stay silent from prepareToPlay on.
+    const auto reverbChannels = juce::jmin(numChannels, numReverbChannels);
+    for (int channel = 0; channel < reverbChannels; ++channel)
+        reverbBuffer.copyFrom(channel, 0, wet, channel, 0, numSamples);
 
-    const auto mix = reverbMix->load();
-    const auto grainWet = wet->load();
-    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    const auto reverbStart = reverbActivity.beginBlock(reverbBuffer.getArrayOfReadPointers(), reverbChannels, numSamples);
+    for (int channel = 0; channel < reverbChannels; ++channel)
+        reverbBuffer.clear(channel, 0, reverbStart);
+
+    if (reverbStart < numSamples)
     {
-        auto* dry = dryBuffer.getReadPointer(juce::jmin(channel, dryBuffer.getNumChannels() - 1));
-        auto* wetGrain = buffer.getWritePointer(channel);
-        auto* wetReverb = reverbBuffer.getReadPointer(juce::jmin(channel, reverbBuffer.getNumChannels() - 1));
+        const StageProfiler::Scope timing(profiler, StageProfiler::reverb);
+        COSMIC_TRACE_SCOPE(&tracer, "reverb");
+        auto reverbBlock = juce::dsp::AudioBlock<float>(reverbBuffer)
+                               .getSubsetChannelBlock(0, static_cast<size_t>(reverbChannels))
+                               .getSubBlock(static_cast<size_t>(reverbStart), static_cast<size_t>(numSamples - reverbStart));
 
-        for (int sample = 0; sample < buffer.getNumSamples(); ++sample)
+        if (useConvolution)
+        {
+            convolution.process(reverbBlock);
+            reverbActivity.setTailSeconds(convolution.getTailSeconds());
+        }
+        else
         {
-            auto combinedWet = wetGrain[sample] * (1.0f - mix) + wetReverb[sample] * mix;
-            wetGrain[sample] = dry[sample] * (1.0f - grainWet) + combinedWet * grainWet;
+            reverb.process(reverbBlock);
+            reverbActivity.setTailSeconds(reverb.getTailSeconds(reverbActivity.getInputPeak(), StageActivity::silenceThreshold));
         }
+
+        // The convolution engines only pause: what they still hold is the response to
+        // input that was already below the threshold, and clearing them would mean
+        // waiting for the loader to build fresh ones.
+        if (reverbActivity.endBlock(reverbBuffer.getArrayOfReadPointers(), reverbChannels, numSamples) && !useConvolution)
+            reverb.reset();
+    }
+
+    {
+        const StageProfiler::Scope timing(profiler, StageProfiler::mix);
+        COSMIC_TRACE_SCOPE(&tracer, "mix");
+
+        const auto mix = smoothing.get(smoothedReverbMix);
+        const auto grainWet = smoothing.get(smoothedGrainWet);
+        const auto mixRamps = smoothing.isRamping(smoothedReverbMix);
+        const auto wetRamps = smoothing.isRamping(smoothedGrainWet);
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* output = buffer.getWritePointer(channel);
+            auto* dry = drySignal.getReadPointer(channel);
+            auto* wetGrain = wet.getReadPointer(channel);
+            auto* wetReverb = reverbBuffer.getReadPointer(channel);
+
+            if (mixRamps && wetRamps)
+                mixChannel<true, true>(output, dry, wetGrain, wetReverb, mix, grainWet, numSamples);
+            else if (mixRamps)
+                mixChannel<true, false>(output, dry, wetGrain, wetReverb, mix, grainWet, numSamples);
+            else if (wetRamps)
+                mixChannel<false, true>(output, dry, wetGrain, wetReverb, mix, grainWet, numSamples);
+            else
+                mixChannel<false, false>(output, dry, wetGrain, wetReverb, mix, grainWet, numSamples);
+        }
+    }
+
+    // The estimate only moves with the settings, the delay, the reverb in use and the
+    // length of a freshly loaded impulse response.
+    const auto convolutionTail = convolution.getTailSeconds();
+    if (p.dirty != 0 || delayChanged || reverbSwitched || convolutionTail != estimatedConvolutionTail)
+    {
+        estimatedConvolutionTail = convolutionTail;
+        tailSeconds.store(estimateTailSeconds(), std::memory_order_relaxed);
+    }
+
+    profiler.endBlock(numSamples, grainEngine.getActiveGrainCount());
+}
+
+double CosmicGrainDelayAudioProcessor::estimateTailSeconds() const noexcept
+{
+    const auto reverbTail = convolutionActive ? convolution.getTailSeconds()
+                                              : reverb.getTailSeconds(1.0f, hostTailThreshold);
+    // Sleeping clears a stage, so its own tail starts from the worst case; the host
+    // only needs the level a full-scale input typically leaves in the cloud.
+    const auto grainTail = grainEngine.getTailSeconds(grainEngine.getTypicalGain(), hostTailThreshold);
+    return juce::jmin(maxHostTailSeconds, grainTail + distortionTailSeconds + reverbTail);
+}
+
+void CosmicGrainDelayAudioProcessor::readParameters(bool markAllDirty) noexcept
+{
+    auto& snapshot = parameterSnapshot;
+    snapshot.dirty = 0;
+
+    for (size_t index = 0; index < ParameterSnapshot::numParameters; ++index)
+    {
+        const auto value = parameterHandles[index]->load(std::memory_order_relaxed);
+        if (markAllDirty || value != snapshot.values[index])
+            snapshot.dirty |= uint64_t { 1 } << index;
+        snapshot.values[index] = value;
     }
 }
 
+void CosmicGrainDelayAudioProcessor::applyParameters() noexcept
+{
+    const auto& p = parameterSnapshot;
+    using Parameter = ParameterSnapshot;
+
+    if (p.dirty == 0)
+        return;
+
+    if (p.changed(Parameter::grainSize))
+        grainEngine.setGrainSize(p[Parameter::grainSize]);
+    if (p.changed(Parameter::density))
+        grainEngine.setDensity(p[Parameter::density]);
+    if (p.changed(Parameter::pitch))
+        grainEngine.setPitch(p[Parameter::pitch]);
+    if (p.changed(Parameter::spread))
+        grainEngine.setSpread(p[Parameter::spread]);
+    if (p.changed(Parameter::grainScatter))
+        grainEngine.setScatter(p[Parameter::grainScatter]);
+    if (p.changed(Parameter::grainPitchJitter))
+        grainEngine.setPitchJitter(p[Parameter::grainPitchJitter]);
+    if (p.changed(Parameter::feedback))
+        grainEngine.setFeedback(p[Parameter::feedback]);
+
+    // Both settings feed the same table request, which the background thread rebuilds.
+    if (p.anyChanged(Parameter::grainWindow, Parameter::grainEnvelopeShape))
+    {
+        grainEngine.setWindowShape(static_cast<GrainWindowBank::Shape>(
+            juce::jlimit(0, GrainWindowBank::numShapes - 1, p.getChoice(Parameter::grainWindow))));
+        grainEngine.setEnvelopeShape(p[Parameter::grainEnvelopeShape]);
+    }
+
+    if (p.changed(Parameter::multicoreRender))
+        grainEngine.setParallelRendering(p.isOn(Parameter::multicoreRender));
+    if (p.changed(Parameter::grainInterpolation))
+        grainEngine.setInterpolation(static_cast<GrainInterpolator::Quality>(
+            juce::jlimit(0, GrainInterpolator::numQualities - 1, p.getChoice(Parameter::grainInterpolation))));
+    if (p.changed(Parameter::grainStereoLink))
+        grainEngine.setStereoLink(p.isOn(Parameter::grainStereoLink));
+
+    auto& governor = grainEngine.getGovernor();
+    if (p.changed(Parameter::governorBudget))
+        governor.setBudget(p[Parameter::governorBudget] / 100.0f);
+    if (p.changed(Parameter::governorStealOldest))
+        governor.setStealPolicy(p.isOn(Parameter::governorStealOldest) ? GrainGovernor::StealPolicy::oldest
+                                                                       : GrainGovernor::StealPolicy::quietest);
+
+    if (p.changed(Parameter::distortionDrive))
+        smoothing.setTarget(smoothedDistortionGain, driveToGain(p[Parameter::distortionDrive]));
+    if (p.anyChanged(Parameter::distortionEnabled, Parameter::distortionMix))
+        smoothing.setTarget(smoothedDistortionBlend, p.isOn(Parameter::distortionEnabled)
+                                                         ? juce::jlimit(0.0f, 1.0f, p[Parameter::distortionMix])
+                                                         : 0.0f);
+    if (p.changed(Parameter::distortionTone))
+        distortionToneFilter.setCutoff(toneToCutoff(p[Parameter::distortionTone]));
+    if (p.changed(Parameter::distortionOversampling))
+        distortionShaper.setOversampling(p.getChoice(Parameter::distortionOversampling));
+    if (p.anyChanged(Parameter::distortionEnabled, Parameter::distortionMix, Parameter::distortionOversampling))
+        smoothing.setTarget(smoothedDryAlignment, smoothing.getTarget(smoothedDistortionBlend) > 0.0f
+                                                      && distortionShaper.getOversamplingFactor() > 1
+                                                      ? 1.0f
+                                                      : 0.0f);
+
+    if (p.changed(Parameter::reverbMix))
+        smoothing.setTarget(smoothedReverbMix, p[Parameter::reverbMix]);
+    if (p.changed(Parameter::grainWet))
+        smoothing.setTarget(smoothedGrainWet, p[Parameter::grainWet]);
+
+    // The network keeps its settings while the convolution runs, so switching back
+    // picks up whatever changed in the meantime.
+    if (p.changed(Parameter::reverbLines))
+        reverb.setLineChoice(p.getChoice(Parameter::reverbLines));
+    if (p.anyChanged(Parameter::reverbSize, Parameter::reverbDamping, Parameter::reverbWidth, Parameter::reverbFreeze))
+        reverb.setParameters({ p[Parameter::reverbSize], p[Parameter::reverbDamping], p[Parameter::reverbWidth],
+                               p.isOn(Parameter::reverbFreeze) });
+    if (p.changed(Parameter::reverbWidth))
+        convolution.setWidth(p[Parameter::reverbWidth]);
+}
+
 void CosmicGrainDelayAudioProcessor::getStateInformation(juce::MemoryBlock& destData)
 {
     if (auto state = parameters.copyState(); state.isValid())
@@ -133,8 +582,20 @@ void CosmicGrainDelayAudioProcessor::getStateInformation(juce::MemoryBlock& dest
 void CosmicGrainDelayAudioProcessor::setStateInformation(const void* data, int sizeInBytes)
 {
     if (auto xml = getXmlFromBinary(data, sizeInBytes))
+    {
         if (xml->hasTagName(parameters.state.getType()))
+        {
             parameters.replaceState(juce::ValueTree::fromXml(*xml));
+            const auto impulsePath = parameters.state.getProperty(impulseResponseProperty).toString();
+            convolution.loadImpulseResponse(juce::File::isAbsolutePath(impulsePath) ? juce::File(impulsePath) : juce::File());
+        }
+    }
+}
+
+void CosmicGrainDelayAudioProcessor::loadImpulseResponse(const juce::File& file)
+{
+    convolution.loadImpulseResponse(file);
+    parameters.state.setProperty(impulseResponseProperty, file.getFullPathName(), nullptr);
 }
 
 juce::AudioProcessorValueTreeState::ParameterLayout CosmicGrainDelayAudioProcessor::createParameterLayout()
@@ -147,6 +608,9 @@ juce::AudioProcessorValueTreeState::ParameterLayout CosmicGrainDelayAudioProcess
     params.push_back(std::make_unique<juce::AudioParameterFloat>("spread", "Comet Spread", juce::NormalisableRange<float>(0.0f, 250.0f, 0.01f), 35.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("grainScatter", "Wormhole Scatter", juce::NormalisableRange<float>(0.0f, 200.0f, 0.01f), 25.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("grainEnvelopeShape", "Gravity Envelope", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("grainWindow", "Gravity Window",
+        juce::NormalisableRange<float>(0.0f, static_cast<float>(CosmicGrainDelayAudioProcessor::grainWindowLabels.size() - 1), 1.0f),
+        0.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("grainPitchJitter", "Quantum Drift", juce::NormalisableRange<float>(0.0f, 12.0f, 0.001f), 2.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("delayTime", "Warp Drift", juce::NormalisableRange<float>(10.0f, 1500.0f, 0.01f), 400.0f));
     params.push_back(std::make_unique<juce::AudioParameterBool>("delaySync", "Temporal Sync", false));
@@ -158,12 +622,41 @@ juce::AudioProcessorValueTreeState::ParameterLayout CosmicGrainDelayAudioProcess
     params.push_back(std::make_unique<juce::AudioParameterFloat>("distortionDrive", "Meteor Burn", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.3f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("distortionTone", "Burn Tone", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.6f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("distortionMix", "Burn Blend", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.5f));
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("distortionOversampling", "Burn Oversampling",
+        juce::NormalisableRange<float>(0.0f, static_cast<float>(CosmicGrainDelayAudioProcessor::distortionOversamplingLabels.size() - 1), 1.0f),
+        0.0f, juce::AudioParameterFloatAttributes().withAutomatable(false)));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("grainWet", "Stardust Blend", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 1.0f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("reverbMix", "Nebula Wash", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.35f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("reverbSize", "Nebula Horizon", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.7f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("reverbDamping", "Stellar Damping", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.3f));
     params.push_back(std::make_unique<juce::AudioParameterFloat>("reverbWidth", "Cosmic Width", juce::NormalisableRange<float>(0.0f, 1.0f, 0.001f), 0.9f));
     params.push_back(std::make_unique<juce::AudioParameterBool>("reverbFreeze", "Space Freeze", false));
+    // Delay lines in the Nebula network: 16 doubles the echo density at roughly twice the cost.
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("reverbLines", "Nebula Density",
+        juce::NormalisableRange<float>(0.0f, static_cast<float>(CosmicGrainDelayAudioProcessor::reverbLineLabels.size() - 1), 1.0f),
+        0.0f, juce::AudioParameterFloatAttributes().withAutomatable(false)));
+    // Swaps the network for the loaded impulse response. Switching restarts the tail,
+    // so hosts should not automate it.
+    params.push_back(std::make_unique<juce::AudioParameterBool>("reverbConvolution", "Space Convolve", false,
+        juce::AudioParameterBoolAttributes().withAutomatable(false)));
+    // A performance setting rather than a sound control, so hosts should not automate it.
+    params.push_back(std::make_unique<juce::AudioParameterBool>("multicoreRender", "Hyperdrive Cores", false,
+        juce::AudioParameterBoolAttributes().withAutomatable(false)));
+    // Trades CPU per instance against playback quality; Linear keeps older sessions unchanged.
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("grainInterpolation", "Warp Fidelity",
+        juce::NormalisableRange<float>(0.0f, static_cast<float>(CosmicGrainDelayAudioProcessor::grainInterpolationLabels.size() - 1), 1.0f),
+        0.0f, juce::AudioParameterFloatAttributes().withAutomatable(false)));
+    // Share of each callback's deadline the grain engine may use before the governor
+    // starts stealing and thinning grains.
+    params.push_back(std::make_unique<juce::AudioParameterFloat>("governorBudget", "Core Budget",
+        juce::NormalisableRange<float>(10.0f, 100.0f, 1.0f), 70.0f,
+        juce::AudioParameterFloatAttributes().withLabel("%").withAutomatable(false)));
+    params.push_back(std::make_unique<juce::AudioParameterBool>("governorStealOldest", "Steal Oldest", false,
+        juce::AudioParameterBoolAttributes().withAutomatable(false)));
+    // Plays each stereo pair of inputs as one grain, halving the grains a stereo
+    // cloud renders; off keeps older sessions unchanged.
+    params.push_back(std::make_unique<juce::AudioParameterBool>("grainStereoLink", "Binary Stars", false,
+        juce::AudioParameterBoolAttributes().withAutomatable(false)));
 
     return { params.begin(), params.end() };
 }
@@ -184,40 +677,78 @@ float CosmicGrainDelayAudioProcessor::resolveDelayMilliseconds(float freeDelayMs
     return juce::jlimit(10.0f, 1500.0f, ms);
 }
 
-void CosmicGrainDelayAudioProcessor::applyDistortion(juce::AudioBuffer<float>& buffer, float drive, float tone, float mix, bool enabled)
+void CosmicGrainDelayAudioProcessor::applyDistortion(juce::AudioBuffer<float>& buffer, int rampOffset)
 {
-    if ((!enabled && mix <= 0.0f) || buffer.getNumSamples() == 0)
+    if (buffer.getNumSamples() == 0)
         return;
 
-    const auto numChannels = buffer.getNumChannels();
-    const auto numSamples = buffer.getNumSamples();
+    const auto numChannels = juce::jmin(buffer.getNumChannels(), distortionBuffer.getNumChannels());
+    const auto numSamples = juce::jmin(buffer.getNumSamples(), distortionBuffer.getNumSamples());
 
-    if (distortionBuffer.getNumChannels() < numChannels || distortionBuffer.getNumSamples() < numSamples)
-        distortionBuffer.setSize(numChannels, numSamples, false, false, true);
+    for (int channel = 0; channel < numChannels; ++channel)
+        distortionBuffer.copyFrom(channel, 0, buffer, channel, 0, numSamples);
 
-    distortionBuffer.makeCopyOf(buffer);
+    auto block = juce::dsp::AudioBlock<float>(distortionBuffer)
+                     .getSubsetChannelBlock(0, static_cast<size_t>(numChannels))
+                     .getSubBlock(0, static_cast<size_t>(numSamples));
 
-    juce::dsp::AudioBlock<float> block(distortionBuffer);
-    juce::dsp::ProcessContextReplacing<float> context(block);
+    // The buffer starts rampOffset samples into the block the ramps cover.
+    const auto gain = smoothing.get(smoothedDistortionGain);
+    if (smoothing.isRamping(smoothedDistortionGain))
+        for (int channel = 0; channel < numChannels; ++channel)
+            juce::FloatVectorOperations::multiply(distortionBuffer.getWritePointer(channel), gain.ramp + rampOffset, numSamples);
+    else
+        block.multiplyBy(gain.value);
 
-    const auto driveAmount = juce::jmap(drive, 0.0f, 1.0f, 1.0f, 10.0f);
-    distortionBuffer.applyGain(driveAmount);
-    distortionShaper.process(context);
+    distortionShaper.process(block);
 
-    const auto cutoff = juce::jmap(tone, 0.0f, 1.0f, 800.0f, 8000.0f);
-    distortionToneFilter.state = juce::dsp::IIR::Coefficients<float>::makeLowPass(currentSampleRate, cutoff);
-    distortionToneFilter.process(context);
+    distortionToneFilter.process(block);
 
-    auto blend = juce::jlimit(0.0f, 1.0f, enabled ? mix : 0.0f);
-    if (blend <= 0.0f)
+    // With no blend applied the grains pass through untouched.
+    auto blend = smoothing.get(smoothedDistortionBlend);
+    const auto blendRamps = smoothing.isRamping(smoothedDistortionBlend);
+    if (!blendRamps && blend.value <= 0.0f)
         return;
 
+    if (blendRamps)
+        blend.ramp += rampOffset;
+
+    // Oversampling shifts the phase of the wet signal, so while a blend is applied the
+    // dry grains take the shaper's resampling filters too. The alignment fades in and
+    // out with the blend, so the grains never jump between filtered and untouched.
+    auto alignment = smoothing.get(smoothedDryAlignment);
+    const auto alignmentRamps = smoothing.isRamping(smoothedDryAlignment);
+    if (alignmentRamps || alignment.value > 0.0f)
+    {
+        for (int channel = 0; channel < numChannels; ++channel)
+            alignedDryBuffer.copyFrom(channel, 0, buffer, channel, 0, numSamples);
+
+        distortionShaper.processDry(juce::dsp::AudioBlock<float>(alignedDryBuffer)
+                                        .getSubsetChannelBlock(0, static_cast<size_t>(numChannels))
+                                        .getSubBlock(0, static_cast<size_t>(numSamples)));
+
+        if (alignmentRamps)
+            alignment.ramp += rampOffset;
+
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            auto* dry = buffer.getWritePointer(channel);
+            auto* aligned = alignedDryBuffer.getReadPointer(channel);
+            if (alignmentRamps)
+                blendChannel<true>(dry, aligned, alignment, numSamples);
+            else
+                blendChannel<false>(dry, aligned, alignment, numSamples);
+        }
+    }
+
     for (int channel = 0; channel < numChannels; ++channel)
     {
         auto* dry = buffer.getWritePointer(channel);
         auto* wet = distortionBuffer.getReadPointer(channel);
-        for (int sample = 0; sample < numSamples; ++sample)
-            dry[sample] = dry[sample] * (1.0f - blend) + wet[sample] * blend;
+        if (blendRamps)
+            blendChannel<true>(dry, wet, blend, numSamples);
+        else
+            blendChannel<false>(dry, wet, blend, numSamples);
     }
 }
 
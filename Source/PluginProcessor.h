@@ -3,18 +3,37 @@
 #include <juce_audio_processors/juce_audio_processors.h>
 #include <juce_dsp/juce_dsp.h>
 #include <array>
+#include <atomic>
+#include <cstdint>
+#include <type_traits>
 
+#include "ConvolutionReverb.h"
 #include "GrainEngine.h"
+#include "NebulaReverb.h"
+#include "SmoothingBank.h"
+#include "SoftClipper.h"
+#include "StageActivity.h"
+#include "StageProfiler.h"
+#include "ToneFilter.h"
+#include "TraceRecorder.h"
 
-class CosmicGrainDelayAudioProcessor : public juce::AudioProcessor
+class CosmicGrainDelayAudioProcessor : public juce::AudioProcessor,
+                                       private juce::AudioProcessorValueTreeState::Listener,
+                                       private juce::AsyncUpdater
 {
 public:
     CosmicGrainDelayAudioProcessor();
-    ~CosmicGrainDelayAudioProcessor() override = default;
+    ~CosmicGrainDelayAudioProcessor() override;
 
     void prepareToPlay(double sampleRate, int samplesPerBlock) override;
     void releaseResources() override;
+    // Mono or stereo into stereo, surround or ambisonics, or any surround layout into itself.
+    bool isBusesLayoutSupported(const BusesLayout& layouts) const override;
+    // Both precisions share one chain; see processSamples().
+    bool supportsDoublePrecisionProcessing() const override { return true; }
     void processBlock(juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock(juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    void audioWorkgroupContextChanged(const juce::AudioWorkgroup& workgroup) override;
 
     juce::AudioProcessorEditor* createEditor() override;
     bool hasEditor() const override { return true; }
@@ -24,7 +43,8 @@ public:
     bool acceptsMidi() const override { return false; }
     bool producesMidi() const override { return false; }
     bool isMidiEffect() const override { return false; }
-    double getTailLengthSeconds() const override { return 4.0; }
+    // Tracks the current settings: feedback, grain length and reverb size.
+    double getTailLengthSeconds() const override { return tailSeconds.load(std::memory_order_relaxed); }
 
     int getNumPrograms() override { return 1; }
     int getCurrentProgram() override { return 0; }
@@ -36,7 +56,30 @@ public:
     void setStateInformation(const void* data, int sizeInBytes) override;
 
     juce::AudioProcessorValueTreeState& getValueTreeState() { return parameters; }
-    GrainEngine::VisualSnapshot getGrainVisualSnapshot() const { return grainEngine.getVisualSnapshot(); }
+
+    // Grain telemetry for the visualiser. The editor enables it while it is open and is
+    // its only reader; see GrainEngine::acquireVisualSnapshot().
+    void setGrainTelemetryEnabled(bool shouldBeEnabled) noexcept { grainEngine.setTelemetryEnabled(shouldBeEnabled); }
+    const GrainEngine::VisualSnapshot& acquireGrainVisualSnapshot() noexcept { return grainEngine.acquireVisualSnapshot(); }
+    // Governor counters and load may be read from any thread.
+    const GrainGovernor& getGrainGovernor() const noexcept { return grainEngine.getGovernor(); }
+    // Audio thread, or between blocks when nothing else is processing.
+    size_t getActiveGrainCount() const noexcept { return grainEngine.getActiveGrainCount(); }
+
+    // Per-stage timing of processBlock, kept only while enabled. The profiling overlay
+    // is the snapshot's only reader; see StageProfiler::acquireSnapshot().
+    void setProfilingEnabled(bool shouldBeEnabled) noexcept { profiler.setEnabled(shouldBeEnabled); }
+    const StageProfiler::Snapshot& acquireProfile() noexcept { return profiler.acquireSnapshot(); }
+    // Any thread: approximate memory this instance holds, including a loaded response.
+    size_t getMemoryFootprint() const noexcept { return preparedMemoryBytes.load(std::memory_order_relaxed) + convolution.getMemoryBytes(); }
+
+    // Impulse response used when Space Convolve is on. Message thread only; the file
+    // loads in the background and its path is stored in the plug-in state.
+    void loadImpulseResponse(const juce::File& file);
+    juce::File getImpulseResponseFile() const { return convolution.getImpulseResponseFile(); }
+    bool hasImpulseResponse() const noexcept { return convolution.hasImpulseResponse(); }
+    // Tail blocks the convolution thread failed to deliver in time since loading.
+    uint64_t getLateConvolutionBlocks() const noexcept { return convolution.getLateTailBlocks(); }
 
     static constexpr std::array<const char*, 19> delayDivisionLabels {
         "Free",
@@ -86,19 +129,191 @@ public:
     static_assert(delayDivisionLabels.size() == delayDivisionBeats.size(),
         "Delay division tables must remain aligned");
 
+    // Indexed by GrainWindowBank::Shape.
+    static constexpr std::array<const char*, GrainWindowBank::numShapes> grainWindowLabels {
+        "Arc",
+        "Hann",
+        "Tukey",
+        "Gauss",
+        "Trapezoid"
+    };
+
+    // Indexed by GrainInterpolator::Quality.
+    static constexpr std::array<const char*, GrainInterpolator::numQualities> grainInterpolationLabels {
+        "Linear",
+        "Hermite",
+        "Lagrange",
+        "Sinc"
+    };
+
+    // Indexed by the SoftClipper oversampling choice.
+    static constexpr std::array<const char*, SoftClipper::numOversamplingChoices> distortionOversamplingLabels {
+        "1x",
+        "2x",
+        "4x"
+    };
+
+    // Indexed by the NebulaReverb line choice.
+    static constexpr std::array<const char*, NebulaReverb::numLineChoices> reverbLineLabels {
+        "8 Lines",
+        "16 Lines"
+    };
+
 private:
     juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
     float resolveDelayMilliseconds(float freeDelayMs, bool syncEnabled, float divisionIndex, double bpm) const;
-    void applyDistortion(juce::AudioBuffer<float>& buffer, float drive, float tone, float mix, bool enabled);
+    // The grain engine, the dry path and the final mix run in the host's precision. The
+    // distortion and reverbs are single precision throughout: their oversampling and
+    // FFT stages only exist for float.
+    template <typename SampleType>
+    void processSamples(juce::AudioBuffer<SampleType>& buffer);
+    // Audio thread: the grains as the single-precision stages take them, in place for a
+    // float block and copied into wetBuffer for a double one.
+    juce::AudioBuffer<float>& getSinglePrecisionWet(juce::AudioBuffer<float>& grains, int numSamples) noexcept;
+    juce::AudioBuffer<float>& getSinglePrecisionWet(juce::AudioBuffer<double>& grains, int numSamples) noexcept;
+    void applyDistortion(juce::AudioBuffer<float>& buffer, int rampOffset);
+    double estimateTailSeconds() const noexcept;
+    // Hyperdrive Cores' render workers exist only while it is on: any thread reports
+    // the change, and the message thread starts or stops the pool.
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    void handleAsyncUpdate() override;
+    void updateRenderThreads();
+
+    // One block's parameter values. Raw handles are resolved once in the constructor:
+    // looking them up by ID builds a juce::String, which would allocate on the audio
+    // thread. Each block copies every value and flags the ones that moved, so only the
+    // settings whose inputs changed are pushed on to the stages.
+    struct ParameterSnapshot
+    {
+        enum Index : size_t
+        {
+            grainSize,
+            density,
+            pitch,
+            spread,
+            grainScatter,
+            grainEnvelopeShape,
+            grainWindow,
+            grainPitchJitter,
+            feedback,
+            grainWet,
+            delayTime,
+            delaySync,
+            delayDivision,
+            distortionEnabled,
+            distortionDrive,
+            distortionTone,
+            distortionMix,
+            distortionOversampling,
+            reverbMix,
+            reverbSize,
+            reverbDamping,
+            reverbWidth,
+            reverbFreeze,
+            reverbLines,
+            reverbConvolution,
+            multicoreRender,
+            grainInterpolation,
+            governorBudget,
+            governorStealOldest,
+            grainStereoLink,
+            numParameters
+        };
+
+        static_assert(numParameters <= 64, "Dirty flags are kept in one 64-bit mask");
+
+        float operator[](Index index) const noexcept { return values[index]; }
+        bool isOn(Index index) const noexcept { return values[index] >= 0.5f; }
+        int getChoice(Index index) const noexcept { return juce::roundToInt(values[index]); }
+
+        bool changed(Index index) const noexcept { return (dirty & (uint64_t { 1 } << index)) != 0; }
+
+        template <typename... Indices>
+        bool anyChanged(Indices... indices) const noexcept
+        {
+            return (changed(indices) || ...);
+        }
+
+        std::array<float, numParameters> values {};
+        uint64_t dirty = 0;
+    };
+
+    // Audio thread: copies the current values into parameterSnapshot. Everything is
+    // flagged when markAllDirty is set, e.g. when preparing.
+    void readParameters(bool markAllDirty) noexcept;
+    // Audio thread: hands the flagged values to the stages they control.
+    void applyParameters() noexcept;
 
     GrainEngine grainEngine;
-    juce::dsp::Reverb reverb;
-    juce::dsp::Reverb::Parameters reverbParams;
+    NebulaReverb reverb;
+    ConvolutionReverb convolution;
+    bool convolutionActive = false; // audio thread: which reverb ran last block
+    // Scratch storage for the dry signal, reverb send and distortion stage. All of it is
+    // sized in prepareToPlay so processBlock never touches the heap. Only the dry buffer
+    // for the host's precision holds storage, and wetBuffer only in double precision.
+    juce::AudioBuffer<float> dryBuffer;
+    juce::AudioBuffer<double> doubleDryBuffer;
+    juce::AudioBuffer<float> wetBuffer;
+    juce::AudioBuffer<float> reverbBuffer;
     juce::AudioBuffer<float> distortionBuffer;
-    juce::dsp::WaveShaper<float> distortionShaper;
-    juce::dsp::ProcessorDuplicator<juce::dsp::IIR::Filter<float>, juce::dsp::IIR::Coefficients<float>> distortionToneFilter;
-    double currentSampleRate = 44100.0;
+    juce::AudioBuffer<float> alignedDryBuffer;
+
+    template <typename SampleType>
+    juce::AudioBuffer<SampleType>& getDryBuffer() noexcept
+    {
+        if constexpr (std::is_same_v<SampleType, double>)
+            return doubleDryBuffer;
+        else
+            return dryBuffer;
+    }
+
+    // How the dry input reaches the outputs when the buses differ, e.g. mono into
+    // stereo: a row of output gains per input channel.
+    bool upmixDry = false;
+    int numDryInputs = 0;
+    std::array<std::array<float, GrainPanner::maxChannels>, 2> dryUpmixGains {};
+    // The reverbs are stereo. On an ambisonic bus they run on the omnidirectional
+    // channel alone; on other buses they return on the first two channels, the front
+    // pair of a surround layout.
+    int numReverbChannels = 2;
+    SoftClipper distortionShaper;
+    ToneFilter distortionToneFilter;
+    // Gain stages that glide per sample. Burn Tone and the reverbs smooth their own
+    // settings; the grain engine smooths its controls itself.
+    enum SmoothedParameter : size_t
+    {
+        smoothedDistortionGain,
+        smoothedDistortionBlend,
+        smoothedDryAlignment, // 1 while the Burn blend needs the dry grains phase-aligned
+        smoothedReverbMix,
+        smoothedGrainWet,
+        numSmoothedParameters
+    };
+
+    SmoothingBank<numSmoothedParameters> smoothing;
+    // Audio thread: lets idle stages skip their work until new input reaches them.
+    StageActivity grainActivity;
+    StageActivity distortionActivity;
+    StageActivity reverbActivity;
+    std::atomic<double> tailSeconds { 0.0 };
+    StageProfiler profiler;
+    std::atomic<size_t> preparedMemoryBytes { 0 };
+   #if COSMIC_ENABLE_TRACING
+    // Each instance writes its own file; see TraceRecorder::getTraceDirectory().
+    TraceRecorder tracer;
+   #endif
+    int maxBlockSize = 0;
+    bool prepared = false;
     juce::AudioProcessorValueTreeState parameters;
+    std::array<std::atomic<float>*, ParameterSnapshot::numParameters> parameterHandles {};
+    ParameterSnapshot parameterSnapshot;
+    // Audio thread: what the last block resolved the delay to and the convolution tail it
+    // assumed, so the delay and the host tail estimate are only redone when they move.
+    float resolvedDelayMs = -1.0f;
+    double estimatedConvolutionTail = -1.0;
+    // Services work that must stay off the audio thread, such as rebuilding grain
+    // window tables. Declared last so it stops before anything it touches is destroyed.
+    juce::TimeSliceThread backgroundThread { "Cosmic Scratches Background" };
 
     JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR(CosmicGrainDelayAudioProcessor)
 };
@@ -0,0 +1,115 @@
+#include "RealtimeAllocationGuard.h"
+
+#if COSMIC_REALTIME_ALLOCATION_CHECKS
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+#if defined(_MSC_VER)
+ #include <malloc.h>
+#endif
+
+namespace
+{
+thread_local int guardDepth = 0;
+
+[[noreturn]] void reportRealtimeAllocation(std::size_t size)
+{
+    // Drop the guard first so nothing below can recurse back into the report.
+    guardDepth = 0;
+    std::fprintf(stderr,
+                 "Cosmic Scratches: %zu-byte heap allocation on the audio thread inside processBlock.\n"
+                 "Break on reportRealtimeAllocation() to find the caller.\n",
+                 size);
+    std::fflush(stderr);
+    std::abort();
+}
+
+void* allocate(std::size_t size)
+{
+    if (guardDepth > 0)
+        reportRealtimeAllocation(size);
+
+    if (auto* ptr = std::malloc(size == 0 ? 1 : size))
+        return ptr;
+
+    throw std::bad_alloc();
+}
+
+void* allocateAligned(std::size_t size, std::align_val_t alignment)
+{
+    if (guardDepth > 0)
+        reportRealtimeAllocation(size);
+
+    // posix_memalign() requires at least pointer alignment.
+    const auto align = std::max(static_cast<std::size_t>(alignment), sizeof(void*));
+    void* ptr = nullptr;
+
+   #if defined(_MSC_VER)
+    ptr = _aligned_malloc(size == 0 ? 1 : size, align);
+   #else
+    if (posix_memalign(&ptr, align, size == 0 ? 1 : size) != 0)
+        ptr = nullptr;
+   #endif
+
+    if (ptr == nullptr)
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+void releaseAligned(void* ptr) noexcept
+{
+   #if defined(_MSC_VER)
+    _aligned_free(ptr);
+   #else
+    std::free(ptr);
+   #endif
+}
+}
+
+ScopedRealtimeAllocationGuard::ScopedRealtimeAllocationGuard() noexcept
+{
+    ++guardDepth;
+}
+
+ScopedRealtimeAllocationGuard::~ScopedRealtimeAllocationGuard() noexcept
+{
+    if (guardDepth > 0)
+        --guardDepth;
+}
+
+bool ScopedRealtimeAllocationGuard::isActiveOnThisThread() noexcept
+{
+    return guardDepth > 0;
+}
+
+// Replacement allocation functions. Every variant routes through the helpers above so
+// that sized, array, nothrow and over-aligned allocations are all caught by the guard.
+void* operator new(std::size_t size) { return allocate(size); }
+void* operator new[](std::size_t size) { return allocate(size); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+    try { return allocate(size); } catch (...) { return nullptr; }
+}
+void* operator new(std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+void* operator new[](std::size_t size, std::align_val_t alignment) { return allocateAligned(size, alignment); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, std::size_t) noexcept { std::free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { std::free(ptr); }
+void operator delete(void* ptr, std::align_val_t) noexcept { releaseAligned(ptr); }
+void operator delete[](void* ptr, std::align_val_t) noexcept { releaseAligned(ptr); }
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept { releaseAligned(ptr); }
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept { releaseAligned(ptr); }
+
+#endif
@@ -0,0 +1,28 @@
+#pragma once
+
+// Debug/test aid for the audio path. When the project is configured with
+// COSMIC_REALTIME_ALLOCATION_CHECKS=ON the global operator new/delete family is
+// replaced, and any heap allocation made while a ScopedRealtimeAllocationGuard is
+// alive on the calling thread aborts the process with a report on stderr. In
+// regular builds the guard compiles down to nothing.
+#ifndef COSMIC_REALTIME_ALLOCATION_CHECKS
+ #define COSMIC_REALTIME_ALLOCATION_CHECKS 0
+#endif
+
+class ScopedRealtimeAllocationGuard
+{
+public:
+   #if COSMIC_REALTIME_ALLOCATION_CHECKS
+    ScopedRealtimeAllocationGuard() noexcept;
+    ~ScopedRealtimeAllocationGuard() noexcept;
+
+    static bool isActiveOnThisThread() noexcept;
+   #else
+    ScopedRealtimeAllocationGuard() noexcept {}
+
+    static constexpr bool isActiveOnThisThread() noexcept { return false; }
+   #endif
+
+    ScopedRealtimeAllocationGuard(const ScopedRealtimeAllocationGuard&) = delete;
+    ScopedRealtimeAllocationGuard& operator=(const ScopedRealtimeAllocationGuard&) = delete;
+};
@@ -0,0 +1,133 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// A fixed set of linearly smoothed parameters, advanced together once per block. A
+// parameter that is gliding fills a per-sample ramp for the block; one that has
+// settled is a constant. Kernels are templated on whether their inputs ramp, so the
+// settled path runs the same code it did before smoothing was added:
+//
+//     if (bank.isRamping(gain)) process<true>(bank.get(gain));
+//     else                      process<false>(bank.get(gain));
+template <size_t NumParameters>
+class SmoothingBank
+{
+public:
+    static_assert(NumParameters > 0 && NumParameters <= 32, "Ramping flags are kept in one 32-bit mask");
+
+    // One parameter over the current block.
+    struct Block
+    {
+        const float* ramp = nullptr; // per-sample values while ramping
+        float value = 0.0f;          // the settled value otherwise
+
+        template <bool ramping>
+        float at(int sample) const noexcept
+        {
+            if constexpr (ramping)
+                return ramp[sample];
+            else
+                return value;
+        }
+
+        float at(int sample) const noexcept { return ramp != nullptr ? ramp[sample] : value; }
+    };
+
+    // Message thread: sizes the ramps and sets how long a change takes to settle.
+    void prepare(double sampleRate, int maxBlockSize, double rampSeconds)
+    {
+        blockCapacity = juce::jmax(1, maxBlockSize);
+        rampSamples = juce::jmax(1, juce::roundToInt(rampSeconds * sampleRate));
+        ramps.assign(NumParameters * static_cast<size_t>(blockCapacity), 0.0f);
+        snapToTargets();
+    }
+
+    // Audio thread: jumps straight to the value, e.g. after a reset.
+    void setCurrentAndTarget(size_t index, float value) noexcept
+    {
+        auto& state = states[index];
+        state.current = state.target = value;
+        state.remaining = 0;
+    }
+
+    // Audio thread: glides from wherever the parameter is now. Repeating the current
+    // target is free.
+    void setTarget(size_t index, float value) noexcept
+    {
+        auto& state = states[index];
+        if (value == state.target)
+            return;
+
+        state.target = value;
+        state.step = (value - state.current) / static_cast<float>(rampSamples);
+        state.remaining = rampSamples;
+    }
+
+    void snapToTargets() noexcept
+    {
+        for (size_t index = 0; index < NumParameters; ++index)
+            setCurrentAndTarget(index, states[index].target);
+        rampingMask = 0;
+    }
+
+    // Audio thread: moves every parameter through the next numSamples (at most the
+    // prepared block size) and fills the ramps of those still gliding.
+    void advance(int numSamples) noexcept
+    {
+        jassert(numSamples <= blockCapacity);
+        numSamples = juce::jmin(numSamples, blockCapacity);
+        rampingMask = 0;
+
+        for (size_t index = 0; index < NumParameters; ++index)
+        {
+            auto& state = states[index];
+            if (state.remaining == 0)
+                continue;
+
+            auto* ramp = ramps.data() + index * static_cast<size_t>(blockCapacity);
+            const auto gliding = juce::jmin(numSamples, state.remaining);
+            auto value = state.current;
+            for (int sample = 0; sample < gliding; ++sample)
+                ramp[sample] = (value += state.step);
+            for (int sample = gliding; sample < numSamples; ++sample)
+                ramp[sample] = state.target;
+
+            state.remaining -= gliding;
+            state.current = state.remaining == 0 ? state.target : value;
+            rampingMask |= uint32_t { 1 } << index;
+        }
+    }
+
+    // Whether the parameter changed during the last advanced block.
+    bool isRamping(size_t index) const noexcept { return (rampingMask & (uint32_t { 1 } << index)) != 0; }
+    bool isAnyRamping() const noexcept { return rampingMask != 0; }
+
+    Block get(size_t index) const noexcept
+    {
+        if (isRamping(index))
+            return { ramps.data() + index * static_cast<size_t>(blockCapacity), states[index].current };
+        return { nullptr, states[index].current };
+    }
+
+    // Value at the end of the last advanced block.
+    float getCurrent(size_t index) const noexcept { return states[index].current; }
+    float getTarget(size_t index) const noexcept { return states[index].target; }
+
+private:
+    struct State
+    {
+        float current = 0.0f;
+        float target = 0.0f;
+        float step = 0.0f;
+        int remaining = 0;
+    };
+
+    std::array<State, NumParameters> states {};
+    std::vector<float> ramps;
+    int blockCapacity = 0;
+    int rampSamples = 1;
+    uint32_t rampingMask = 0;
+};
@@ -0,0 +1,163 @@
+#include "SoftClipper.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+using FloatVector = juce::dsp::SIMDRegister<float>;
+
+// g(u) = (15u - 10u^3 + 3u^5) / 8 reaches +-1 with zero slope and curvature at
+// |u| = 1. Scaling the input by 8/15 gives unit slope at the origin, like tanh.
+constexpr float inputScale = 8.0f / 15.0f;
+
+// Below this input step the ADAA quotient loses precision to cancellation, so the
+// curve is evaluated at the midpoint instead; the two agree to O(step^2).
+constexpr float adaaTolerance = 1.0e-2f;
+
+FloatVector clampUnit(FloatVector u) noexcept
+{
+    return FloatVector::min(FloatVector::expand(1.0f), FloatVector::max(FloatVector::expand(-1.0f), u));
+}
+
+FloatVector shapeVector(FloatVector x) noexcept
+{
+    const auto u = clampUnit(x * inputScale);
+    const auto u2 = u * u;
+    return u * ((u2 * 3.0f - 10.0f) * u2 + 15.0f) * 0.125f;
+}
+
+FloatVector antiderivativeVector(FloatVector x) noexcept
+{
+    // G(u) = (7.5u^2 - 2.5u^4 + 0.5u^6) / 8 inside the knee, continued linearly
+    // beyond it, where the curve is flat at +-1.
+    const auto scaled = x * inputScale;
+    const auto u = clampUnit(scaled);
+    const auto u2 = u * u;
+    const auto polynomial = ((u2 * 0.5f - 2.5f) * u2 + 7.5f) * u2 * 0.125f;
+    return (polynomial + FloatVector::abs(scaled) - FloatVector::abs(u)) * (1.0f / inputScale);
+}
+}
+
+void SoftClipper::prepare(const juce::dsp::ProcessSpec& spec)
+{
+    for (auto* bank : { &oversamplers, &dryOversamplers })
+    {
+        for (size_t i = 0; i < bank->size(); ++i)
+        {
+            (*bank)[i] = std::make_unique<juce::dsp::Oversampling<float>>(
+                static_cast<size_t>(spec.numChannels), i + 1, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, false);
+            (*bank)[i]->initProcessing(static_cast<size_t>(spec.maximumBlockSize));
+        }
+    }
+
+    channelStates.assign(static_cast<size_t>(spec.numChannels), ChannelState{});
+}
+
+void SoftClipper::reset() noexcept
+{
+    for (auto* bank : { &oversamplers, &dryOversamplers })
+        for (auto& oversampler : *bank)
+            if (oversampler != nullptr)
+                oversampler->reset();
+
+    std::fill(channelStates.begin(), channelStates.end(), ChannelState{});
+}
+
+void SoftClipper::setOversampling(int choice) noexcept
+{
+    choice = juce::jlimit(0, numOversamplingChoices - 1, choice);
+    if (choice == oversamplingChoice)
+        return;
+
+    oversamplingChoice = choice;
+    reset();
+}
+
+void SoftClipper::process(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    const auto numChannels = juce::jmin(block.getNumChannels(), channelStates.size());
+
+    if (oversamplingChoice == 0 || oversamplers[0] == nullptr)
+    {
+        for (size_t ch = 0; ch < numChannels; ++ch)
+            processChannel(block.getChannelPointer(ch), block.getNumSamples(), channelStates[ch]);
+        return;
+    }
+
+    auto& oversampler = *oversamplers[static_cast<size_t>(oversamplingChoice - 1)];
+    auto upsampled = oversampler.processSamplesUp(block);
+
+    for (size_t ch = 0; ch < numChannels; ++ch)
+        processChannel(upsampled.getChannelPointer(ch), upsampled.getNumSamples(), channelStates[ch]);
+
+    auto output = block;
+    oversampler.processSamplesDown(output);
+}
+
+void SoftClipper::processDry(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    if (oversamplingChoice == 0 || dryOversamplers[0] == nullptr)
+        return;
+
+    auto& oversampler = *dryOversamplers[static_cast<size_t>(oversamplingChoice - 1)];
+    oversampler.processSamplesUp(block);
+
+    auto output = block;
+    oversampler.processSamplesDown(output);
+}
+
+void SoftClipper::processChannel(float* data, size_t numSamples, ChannelState& state) noexcept
+{
+    constexpr auto width = FloatVector::SIMDNumElements;
+
+    alignas(64) float current[width];
+    alignas(64) float previous[width];
+    alignas(64) float currentF[width];
+    alignas(64) float previousF[width];
+    alignas(64) float quotientTerms[width];
+    alignas(64) float steps[width];
+    alignas(64) float midpoints[width];
+
+    for (size_t start = 0; start < numSamples; start += width)
+    {
+        const auto count = juce::jmin(width, numSamples - start);
+
+        // A short final group repeats its last sample; only real samples are written back.
+        for (size_t l = 0; l < width; ++l)
+            current[l] = data[start + juce::jmin(l, count - 1)];
+
+        previous[0] = state.lastInput;
+        for (size_t l = 1; l < width; ++l)
+            previous[l] = current[l - 1];
+
+        const auto x = FloatVector::fromRawArray(current);
+        const auto xPrevious = FloatVector::fromRawArray(previous);
+
+        // F is evaluated once per sample; the previous lane's value is shifted across.
+        antiderivativeVector(x).copyToRawArray(currentF);
+        previousF[0] = state.lastAntiderivative;
+        for (size_t l = 1; l < width; ++l)
+            previousF[l] = currentF[l - 1];
+
+        (FloatVector::fromRawArray(currentF) - FloatVector::fromRawArray(previousF)).copyToRawArray(quotientTerms);
+        (x - xPrevious).copyToRawArray(steps);
+        shapeVector((x + xPrevious) * 0.5f).copyToRawArray(midpoints);
+
+        for (size_t l = 0; l < count; ++l)
+            data[start + l] = std::abs(steps[l]) > adaaTolerance ? quotientTerms[l] / steps[l] : midpoints[l];
+
+        state.lastInput = current[count - 1];
+        state.lastAntiderivative = currentF[count - 1];
+    }
+}
+
+float SoftClipper::shape(float x) noexcept
+{
+    return shapeVector(FloatVector::expand(x)).get(0);
+}
+
+float SoftClipper::antiderivative(float x) noexcept
+{
+    return antiderivativeVector(FloatVector::expand(x)).get(0);
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <memory>
+#include <vector>
+
+// Meteor Burn saturation: a quintic soft clipper shaped like tanh, evaluated a
+// SIMD register at a time with first-order antiderivative anti-aliasing (ADAA).
+// Each output sample is the mean of the curve between consecutive inputs,
+// (F(x[n]) - F(x[n-1])) / (x[n] - x[n-1]), which suppresses most of the
+// aliasing a memoryless shaper produces at high drive. Optional 2x/4x polyphase
+// IIR oversampling removes most of what is left; its filters shift the phase of
+// the output, so a dry signal blended with it goes through processDry() first.
+class SoftClipper
+{
+public:
+    static constexpr int numOversamplingChoices = 3; // 1x, 2x, 4x
+
+    // Message thread: allocates the oversampling filters for the largest block.
+    void prepare(const juce::dsp::ProcessSpec& spec);
+    void reset() noexcept;
+
+    // Audio thread: 0 = off, 1 = 2x, 2 = 4x.
+    void setOversampling(int choice) noexcept;
+    int getOversamplingFactor() const noexcept { return 1 << oversamplingChoice; }
+
+    // Audio thread: saturates the block in place.
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    // Audio thread: runs a block through the same up- and downsampling filters as
+    // process() without shaping it, so blending it with the saturated signal does
+    // not comb-filter. Does nothing at 1x.
+    void processDry(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+    // Scalar forms of the curve and its antiderivative.
+    static float shape(float x) noexcept;
+    static float antiderivative(float x) noexcept;
+
+private:
+    struct ChannelState
+    {
+        float lastInput = 0.0f;
+        float lastAntiderivative = 0.0f;
+    };
+
+    void processChannel(float* data, size_t numSamples, ChannelState& state) noexcept;
+
+    using Oversamplers = std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, numOversamplingChoices - 1>;
+
+    Oversamplers oversamplers;
+    Oversamplers dryOversamplers;
+    std::vector<ChannelState> channelStates;
+    int oversamplingChoice = 0;
+};
@@ -0,0 +1,119 @@
+#include "StageActivity.h"
+
+#include <cmath>
+#include <limits>
+
+void StageActivity::prepare(double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+    reset();
+}
+
+void StageActivity::reset() noexcept
+{
+    asleep = false;
+    silentSamples = 0;
+    inputPeak = 0.0f;
+}
+
+void StageActivity::setPeakGain(float gain) noexcept
+{
+    wakeThreshold = silenceThreshold / juce::jmax(1.0f, gain);
+}
+
+void StageActivity::setTailSeconds(double seconds) noexcept
+{
+    // Round up so a partial sample of tail still counts.
+    const auto samples = std::ceil(seconds * sampleRate);
+    tailSamples = samples < static_cast<double>(std::numeric_limits<int64_t>::max())
+                      ? static_cast<int64_t>(juce::jmax(0.0, samples))
+                      : std::numeric_limits<int64_t>::max();
+}
+
+template <typename SampleType>
+int StageActivity::beginBlock(const SampleType* const* input, int numChannels, int numSamples) noexcept
+{
+    auto start = 0;
+
+    if (asleep)
+    {
+        start = findFirstAudible(input, numChannels, numSamples);
+        if (start == numSamples)
+            return numSamples;
+
+        asleep = false;
+        silentSamples = 0;
+        inputPeak = 0.0f;
+    }
+
+    const auto peak = getPeak(input, numChannels, start, numSamples - start);
+    if (peak > wakeThreshold)
+    {
+        // Counting from the end of the block keeps this a block-rate check; it only
+        // ever delays sleep.
+        silentSamples = 0;
+        inputPeak = juce::jmax(inputPeak, peak);
+    }
+    else
+    {
+        silentSamples += numSamples - start;
+    }
+
+    return start;
+}
+
+template <typename SampleType>
+bool StageActivity::endBlock(const SampleType* const* output, int numChannels, int numSamples) noexcept
+{
+    if (asleep || silentSamples < tailSamples)
+        return false;
+
+    if (getPeak(output, numChannels, 0, numSamples) > silenceThreshold)
+        return false;
+
+    asleep = true;
+    inputPeak = 0.0f;
+    return true;
+}
+
+template <typename SampleType>
+float StageActivity::getPeak(const SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept
+{
+    auto peak = SampleType();
+    for (int channel = 0; channel < numChannels && numSamples > 0; ++channel)
+    {
+        const auto range = juce::FloatVectorOperations::findMinAndMax(channels[channel] + startSample, numSamples);
+        peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+    }
+    return static_cast<float>(peak);
+}
+
+template <typename SampleType>
+int StageActivity::findFirstAudible(const SampleType* const* input, int numChannels, int numSamples) const noexcept
+{
+    // Silent blocks, the common case while asleep, take the vectorised peak scan only.
+    if (getPeak(input, numChannels, 0, numSamples) <= wakeThreshold)
+        return numSamples;
+
+    auto first = numSamples;
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        const auto* samples = input[channel];
+        for (int i = 0; i < first; ++i)
+        {
+            if (std::abs(samples[i]) > wakeThreshold)
+            {
+                first = i;
+                break;
+            }
+        }
+    }
+    return first;
+}
+
+template int StageActivity::beginBlock(const float* const*, int, int) noexcept;
+template int StageActivity::beginBlock(const double* const*, int, int) noexcept;
+template bool StageActivity::endBlock(const float* const*, int, int) noexcept;
+template bool StageActivity::endBlock(const double* const*, int, int) noexcept;
+template float StageActivity::getPeak(const float* const*, int, int, int) noexcept;
+template float StageActivity::getPeak(const double* const*, int, int, int) noexcept;
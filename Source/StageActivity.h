@@ -0,0 +1,61 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <cstdint>
+
+// Lets a processing stage skip its work while its output is provably silent. The stage
+// stays awake while its input carries signal, and afterwards for as long as the tail
+// estimate for that input says it can keep sounding. Once that time has passed and a
+// block's output is below the threshold too, the stage sleeps: the caller clears its
+// state and stops running it. An input sample that could produce output above the
+// threshold wakes it, and processing resumes at exactly that sample.
+class StageActivity
+{
+public:
+    // -100 dBFS.
+    static constexpr float silenceThreshold = 1.0e-5f;
+
+    void prepare(double sampleRate) noexcept;
+
+    // Audio thread: wakes the stage, for example after its settings jumped.
+    void reset() noexcept;
+
+    // Audio thread: the most the stage can amplify its input. Quieter input than
+    // silenceThreshold / gain cannot wake it.
+    void setPeakGain(float gain) noexcept;
+
+    // Audio thread, before running the stage: returns the first sample it must
+    // process. That is 0 while it is awake, numSamples while it sleeps through the
+    // block, or the first audible input sample when it wakes partway through.
+    // Takes float or double channels.
+    template <typename SampleType>
+    int beginBlock(const SampleType* const* input, int numChannels, int numSamples) noexcept;
+
+    // Audio thread, after running the stage: how long output can continue after the
+    // input falls silent, estimated for getInputPeak(). Infinity keeps it awake.
+    void setTailSeconds(double seconds) noexcept;
+
+    // Audio thread, after running the stage over the whole block: returns true when
+    // the stage has just fallen asleep, so its state should be cleared.
+    template <typename SampleType>
+    bool endBlock(const SampleType* const* output, int numChannels, int numSamples) noexcept;
+
+    bool isAsleep() const noexcept { return asleep; }
+
+    // Loudest input since the stage last woke.
+    float getInputPeak() const noexcept { return inputPeak; }
+
+    template <typename SampleType>
+    static float getPeak(const SampleType* const* channels, int numChannels, int startSample, int numSamples) noexcept;
+
+private:
+    template <typename SampleType>
+    int findFirstAudible(const SampleType* const* input, int numChannels, int numSamples) const noexcept;
+
+    double sampleRate = 44100.0;
+    float wakeThreshold = silenceThreshold;
+    float inputPeak = 0.0f;
+    int64_t silentSamples = 0;
+    int64_t tailSamples = 0;
+    bool asleep = false;
+};
@@ -0,0 +1,106 @@
+#include "StageProfiler.h"
+
+#include <algorithm>
+#include <cmath>
+
+double StageProfiler::getPercentileMicros(const StageStats& stats, uint32_t blocksInWindow, float fraction) noexcept
+{
+    if (blocksInWindow == 0)
+        return 0.0;
+
+    const auto target = static_cast<uint32_t>(std::ceil(static_cast<double>(blocksInWindow) * juce::jlimit(0.0f, 1.0f, fraction)));
+    uint32_t seen = 0;
+    for (int bin = 0; bin < numBins; ++bin)
+    {
+        seen += stats.histogram[static_cast<size_t>(bin)];
+        if (seen >= juce::jmax(1u, target))
+            return std::ldexp(1.0, bin);
+    }
+    return std::ldexp(1.0, numBins - 1);
+}
+
+void StageProfiler::prepare(double newSampleRate) noexcept
+{
+    sampleRate = newSampleRate;
+    window = Window {};
+    measuring = false;
+    snapshots.forEachBuffer([](Snapshot& snapshot) { snapshot = Snapshot {}; });
+}
+
+int StageProfiler::binFor(double micros) noexcept
+{
+    if (micros < 1.0)
+        return 0;
+
+    int exponent = 0;
+    std::frexp(micros, &exponent);
+    return juce::jmin(numBins - 1, exponent);
+}
+
+void StageProfiler::beginBlock() noexcept
+{
+    const auto enabled = isEnabled();
+
+    // A window left over from an earlier session would mix stale blocks into the new one.
+    if (enabled && !measuring)
+        window = Window {};
+
+    measuring = enabled;
+    stageTicks.fill(0);
+}
+
+void StageProfiler::endBlock(int numSamples, size_t activeGrains) noexcept
+{
+    if (!measuring)
+        return;
+
+    const auto ticksPerMicro = static_cast<double>(juce::Time::getHighResolutionTicksPerSecond()) * 1.0e-6;
+    const auto slot = static_cast<size_t>(window.position);
+    const auto full = window.count == windowBlocks;
+
+    auto& snapshot = snapshots.getWriteBuffer();
+    snapshot.blockMicros = 0.0;
+
+    for (size_t stage = 0; stage < numStages; ++stage)
+    {
+        const auto micros = static_cast<double>(stageTicks[stage]) / ticksPerMicro;
+        const auto bin = binFor(micros);
+
+        auto& histogram = window.histogram[stage];
+        auto& bins = window.bins[stage];
+        auto& times = window.micros[stage];
+
+        if (full)
+        {
+            --histogram[bins[slot]];
+            window.totalMicros[stage] -= times[slot];
+        }
+
+        ++histogram[static_cast<size_t>(bin)];
+        bins[slot] = static_cast<uint8_t>(bin);
+        times[slot] = static_cast<float>(micros);
+        window.totalMicros[stage] += times[slot];
+
+        const auto count = full ? windowBlocks : window.count + 1;
+        auto& stats = snapshot.stages[stage];
+        stats.histogram = histogram;
+        stats.lastMicros = micros;
+        stats.meanMicros = juce::jmax(0.0, window.totalMicros[stage]) / static_cast<double>(count);
+        stats.peakMicros = *std::max_element(times.begin(), times.begin() + count);
+        snapshot.blockMicros += micros;
+    }
+
+    window.position = (window.position + 1) % windowBlocks;
+    window.count = juce::jmin(windowBlocks, window.count + 1);
+
+    snapshot.deadlineMicros = static_cast<double>(numSamples) / sampleRate * 1.0e6;
+    snapshot.blocksInWindow = static_cast<uint32_t>(window.count);
+    snapshot.activeGrains = activeGrains;
+    snapshots.publish();
+}
+
+const StageProfiler::Snapshot& StageProfiler::acquireSnapshot() noexcept
+{
+    snapshots.acquireLatest();
+    return snapshots.getReadBuffer();
+}
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+#include "TripleBuffer.h"
+
+// Times each stage of the processor's block on the audio thread and keeps a rolling
+// histogram of the last windowBlocks blocks per stage. Bins are a factor of two wide
+// in microseconds, so one block costs a pair of clock reads and a couple of integer
+// updates per stage. The finished statistics are published through a triple buffer
+// after every block; nothing is measured while profiling is disabled.
+class StageProfiler
+{
+public:
+    enum Stage
+    {
+        grains,
+        distortion,
+        reverb,
+        mix,
+        numStages
+    };
+
+    static constexpr std::array<const char*, numStages> stageNames { "Grains", "Burn", "Nebula", "Mix" };
+
+    // Bin 0 holds times under 1 us; bin b holds [2^(b-1), 2^b) us. The last bin also
+    // takes everything slower, from about 16 ms.
+    static constexpr int numBins = 16;
+    static constexpr int windowBlocks = 256;
+
+    struct StageStats
+    {
+        std::array<uint32_t, numBins> histogram {};
+        double lastMicros = 0.0;
+        double meanMicros = 0.0;  // over the window
+        double peakMicros = 0.0;  // over the window
+    };
+
+    struct Snapshot
+    {
+        std::array<StageStats, numStages> stages {};
+        double blockMicros = 0.0;     // all stages of the last block
+        double deadlineMicros = 0.0;  // duration of the last block at the current sample rate
+        uint32_t blocksInWindow = 0;
+        size_t activeGrains = 0;
+    };
+
+    // Upper edge of the bin below which the given fraction of the window fell.
+    static double getPercentileMicros(const StageStats& stats, uint32_t blocksInWindow, float fraction) noexcept;
+
+    // Message thread, while the audio thread is stopped.
+    void prepare(double sampleRate) noexcept;
+
+    // Any thread.
+    void setEnabled(bool shouldBeEnabled) noexcept { enabledFlag.store(shouldBeEnabled, std::memory_order_relaxed); }
+    bool isEnabled() const noexcept { return enabledFlag.load(std::memory_order_relaxed); }
+
+    // Audio thread: brackets one stage. A no-op unless the block was opened enabled.
+    class Scope
+    {
+    public:
+        Scope(StageProfiler& ownerToUse, Stage stageToTime) noexcept
+            : owner(ownerToUse), stage(stageToTime), startTicks(owner.measuring ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        ~Scope() noexcept
+        {
+            if (owner.measuring)
+                owner.stageTicks[static_cast<size_t>(stage)] += juce::Time::getHighResolutionTicks() - startTicks;
+        }
+
+    private:
+        StageProfiler& owner;
+        Stage stage;
+        int64_t startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+    // Audio thread: open and close every processed block. endBlock() folds the block
+    // into the window and publishes it with the grain pool's occupancy.
+    void beginBlock() noexcept;
+    void endBlock(int numSamples, size_t activeGrains) noexcept;
+
+    // Single reader: swaps in the newest published snapshot, which stays valid and
+    // unchanged until the reader's next call.
+    const Snapshot& acquireSnapshot() noexcept;
+
+private:
+    static int binFor(double micros) noexcept;
+
+    double sampleRate = 44100.0;
+    bool measuring = false;
+    std::array<int64_t, numStages> stageTicks {};
+
+    // Audio thread only: the window's running state. Each block's bin and time per stage
+    // are kept so they can be taken back out when the block leaves the window.
+    struct Window
+    {
+        std::array<std::array<uint32_t, numBins>, numStages> histogram {};
+        std::array<std::array<uint8_t, windowBlocks>, numStages> bins {};
+        std::array<std::array<float, windowBlocks>, numStages> micros {};
+        std::array<double, numStages> totalMicros {};
+        int position = 0;
+        int count = 0;
+    };
+
+    Window window;
+
+    alignas(64) std::atomic<bool> enabledFlag { false };
+    alignas(64) TripleBuffer<Snapshot> snapshots;
+};
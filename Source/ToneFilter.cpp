@@ -0,0 +1,85 @@
+#include "ToneFilter.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+constexpr double smoothingSeconds = 0.02;
+
+// Butterworth damping, matching the IIR low-pass this filter replaced.
+constexpr float damping = juce::MathConstants<float>::sqrt2;
+}
+
+void ToneFilter::prepare(const juce::dsp::ProcessSpec& spec, float initialCutoffHz)
+{
+    sampleRate = spec.sampleRate;
+    const auto width = FloatVector::SIMDNumElements;
+    groups.assign((static_cast<size_t>(spec.numChannels) + width - 1) / width, GroupState{});
+
+    cutoff.reset(sampleRate, smoothingSeconds);
+    cutoff.setCurrentAndTargetValue(initialCutoffHz);
+    coefficients = makeCoefficients(initialCutoffHz);
+}
+
+void ToneFilter::reset() noexcept
+{
+    std::fill(groups.begin(), groups.end(), GroupState{});
+}
+
+void ToneFilter::setCutoff(float cutoffHz) noexcept
+{
+    cutoff.setTargetValue(cutoffHz);
+}
+
+ToneFilter::Coefficients ToneFilter::makeCoefficients(float cutoffHz) const noexcept
+{
+    const auto nyquistSafe = juce::jmin(static_cast<double>(cutoffHz), sampleRate * 0.49);
+    const auto g = static_cast<float>(std::tan(juce::MathConstants<double>::pi * nyquistSafe / sampleRate));
+
+    Coefficients c;
+    c.a1 = 1.0f / (1.0f + g * (g + damping));
+    c.a2 = g * c.a1;
+    c.a3 = g * c.a2;
+    return c;
+}
+
+void ToneFilter::process(const juce::dsp::AudioBlock<float>& block) noexcept
+{
+    constexpr auto width = FloatVector::SIMDNumElements;
+    const auto numChannels = juce::jmin(block.getNumChannels(), groups.size() * width);
+    const auto numSamples = block.getNumSamples();
+
+    alignas(64) float lanes[width];
+
+    for (size_t sample = 0; sample < numSamples; ++sample)
+    {
+        if (cutoff.isSmoothing())
+            coefficients = makeCoefficients(cutoff.getNextValue());
+
+        const auto a1 = coefficients.a1;
+        const auto a2 = coefficients.a2;
+        const auto a3 = coefficients.a3;
+
+        for (size_t group = 0; group * width < numChannels; ++group)
+        {
+            const auto first = group * width;
+            const auto count = juce::jmin(width, numChannels - first);
+
+            for (size_t l = 0; l < width; ++l)
+                lanes[l] = l < count ? block.getChannelPointer(first + l)[sample] : 0.0f;
+
+            auto& state = groups[group];
+            const auto v0 = FloatVector::fromRawArray(lanes);
+            const auto v3 = v0 - state.ic2eq;
+            const auto v1 = state.ic1eq * a1 + v3 * a2;
+            const auto v2 = state.ic2eq + state.ic1eq * a2 + v3 * a3;
+            state.ic1eq = v1 * 2.0f - state.ic1eq;
+            state.ic2eq = v2 * 2.0f - state.ic2eq;
+
+            v2.copyToRawArray(lanes);
+            for (size_t l = 0; l < count; ++l)
+                block.getChannelPointer(first + l)[sample] = lanes[l];
+        }
+    }
+}
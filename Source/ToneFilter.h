@@ -0,0 +1,46 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <vector>
+
+// Low-pass tone control built as a topology-preserving (trapezoidal) state-variable
+// filter. Its state stays consistent while the cutoff moves, so the cutoff can be
+// smoothed per sample without zipper noise. Coefficients are recomputed only while
+// that smoothing is in progress. Channels are packed into SIMD lanes and filtered
+// together, one register per group of channels.
+class ToneFilter
+{
+public:
+    // Message thread: sizes the channel groups and jumps to the given cutoff.
+    void prepare(const juce::dsp::ProcessSpec& spec, float initialCutoffHz);
+    void reset() noexcept;
+
+    // Audio thread: glides to the new cutoff over the smoothing time.
+    void setCutoff(float cutoffHz) noexcept;
+
+    // Audio thread: filters the block in place.
+    void process(const juce::dsp::AudioBlock<float>& block) noexcept;
+
+private:
+    using FloatVector = juce::dsp::SIMDRegister<float>;
+
+    struct Coefficients
+    {
+        float a1 = 1.0f;
+        float a2 = 0.0f;
+        float a3 = 0.0f;
+    };
+
+    struct GroupState
+    {
+        FloatVector ic1eq = FloatVector::expand(0.0f);
+        FloatVector ic2eq = FloatVector::expand(0.0f);
+    };
+
+    Coefficients makeCoefficients(float cutoffHz) const noexcept;
+
+    double sampleRate = 44100.0;
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> cutoff { 1000.0f };
+    Coefficients coefficients;
+    std::vector<GroupState> groups;
+};
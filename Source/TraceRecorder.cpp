@@ -0,0 +1,117 @@
+#include "TraceRecorder.h"
+
+#if COSMIC_ENABLE_TRACING
+
+namespace
+{
+constexpr int writerIntervalMs = 50;
+
+std::atomic<int> nextProcessId { 1 };
+}
+
+class TraceRecorder::Writer : public juce::Thread
+{
+public:
+    explicit Writer(TraceRecorder& ownerToUse) : juce::Thread("Cosmic Scratches Trace Writer"), owner(ownerToUse)
+    {
+        startThread(juce::Thread::Priority::background);
+    }
+
+    ~Writer() override { stopThread(1000); }
+
+    void run() override
+    {
+        while (!threadShouldExit())
+        {
+            owner.drain();
+            wait(writerIntervalMs);
+        }
+    }
+
+private:
+    TraceRecorder& owner;
+};
+
+TraceRecorder::TraceRecorder()
+    : ring(ringSize),
+      originTicks(juce::Time::getHighResolutionTicks()),
+      microsPerTick(1.0e6 / static_cast<double>(juce::Time::getHighResolutionTicksPerSecond())),
+      processId(nextProcessId.fetch_add(1))
+{
+    // Chrome keeps separate rows per pid, so every instance gets its own.
+    const auto directory = getTraceDirectory();
+    directory.createDirectory();
+    file = directory.getNonexistentChildFile("trace-" + juce::Time::getCurrentTime().formatted("%Y%m%d-%H%M%S")
+                                                 + "-" + juce::String(processId),
+                                             ".json", false);
+
+    stream = file.createOutputStream();
+    if (stream == nullptr)
+        return;
+
+    *stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[\n"
+            << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":" << processId
+            << ",\"args\":{\"name\":\"Cosmic Scratches " << processId << "\"}},\n"
+            << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":" << processId
+            << ",\"tid\":1,\"args\":{\"name\":\"Audio\"}}";
+
+    writer = std::make_unique<Writer>(*this);
+}
+
+TraceRecorder::~TraceRecorder()
+{
+    writer.reset();
+
+    if (stream != nullptr)
+    {
+        drain();
+        *stream << "\n],\"otherData\":{\"droppedEvents\":\"" << juce::String(static_cast<juce::int64>(getDroppedEvents())) << "\"}}\n";
+        stream->flush();
+    }
+}
+
+juce::File TraceRecorder::getTraceDirectory()
+{
+    return juce::File::getSpecialLocation(juce::File::userApplicationDataDirectory)
+        .getChildFile("Cosmic Scratches")
+        .getChildFile("Traces");
+}
+
+void TraceRecorder::record(const char* name, int64_t startTicks, int64_t endTicks) noexcept
+{
+    const auto write = writeIndex.load(std::memory_order_relaxed);
+    if (write - readIndex.load(std::memory_order_acquire) >= ringSize)
+    {
+        dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+
+    ring[write & ringMask] = { name, startTicks, endTicks };
+    writeIndex.store(write + 1, std::memory_order_release);
+}
+
+void TraceRecorder::drain()
+{
+    if (stream == nullptr)
+        return;
+
+    const auto write = writeIndex.load(std::memory_order_acquire);
+    auto read = readIndex.load(std::memory_order_relaxed);
+
+    // Complete ("X") events carry both ends of a scope, so a dropped event can never
+    // leave an unmatched begin or end behind.
+    for (; read != write; ++read)
+    {
+        const auto& event = ring[read & ringMask];
+        const auto start = static_cast<double>(event.startTicks - originTicks) * microsPerTick;
+        const auto duration = static_cast<double>(event.endTicks - event.startTicks) * microsPerTick;
+
+        *stream << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":" << processId << ",\"tid\":1,\"ts\":"
+                << juce::String(start, 3) << ",\"dur\":" << juce::String(duration, 3) << "}";
+    }
+
+    readIndex.store(read, std::memory_order_release);
+    stream->flush();
+}
+
+#endif
@@ -0,0 +1,110 @@
+#pragma once
+
+// Debug aid for glitches that averages hide. When the project is configured with
+// COSMIC_ENABLE_TRACING=ON, COSMIC_TRACE_SCOPE records when a scope began and how
+// long it ran. Events go into a lock-free ring that a background thread drains to a
+// Chrome trace file, which chrome://tracing and ui.perfetto.dev open as a timeline.
+// In regular builds the macro, the recorder and every member that refers to it
+// compile to nothing.
+#ifndef COSMIC_ENABLE_TRACING
+ #define COSMIC_ENABLE_TRACING 0
+#endif
+
+#if COSMIC_ENABLE_TRACING
+
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// One recorder per processor instance, each writing its own file. Only one thread may
+// record into a recorder: the audio thread, which owns processBlock.
+class TraceRecorder
+{
+public:
+    // About a second of events at 64-sample blocks with every scope firing, and several
+    // writer wake-ups' worth at typical block sizes.
+    static constexpr size_t ringSize = size_t { 1 } << 16;
+
+    // Starts a new file in getTraceDirectory() and the thread that writes it.
+    TraceRecorder();
+    // Writes out the remaining events and closes the file.
+    ~TraceRecorder();
+
+    static juce::File getTraceDirectory();
+    const juce::File& getFile() const noexcept { return file; }
+
+    // Producer thread. The name must outlive the recorder, so pass string literals.
+    // A full ring drops the event and counts it.
+    void record(const char* name, int64_t startTicks, int64_t endTicks) noexcept;
+
+    // Any thread.
+    uint64_t getDroppedEvents() const noexcept { return dropped.load(std::memory_order_relaxed); }
+
+    // Producer thread: records the scope it spans. A null recorder records nothing.
+    class Scope
+    {
+    public:
+        Scope(TraceRecorder* recorderToUse, const char* nameToUse) noexcept
+            : recorder(recorderToUse), name(nameToUse), startTicks(recorder != nullptr ? juce::Time::getHighResolutionTicks() : 0)
+        {
+        }
+
+        ~Scope() noexcept
+        {
+            if (recorder != nullptr)
+                recorder->record(name, startTicks, juce::Time::getHighResolutionTicks());
+        }
+
+    private:
+        TraceRecorder* recorder;
+        const char* name;
+        int64_t startTicks;
+
+        JUCE_DECLARE_NON_COPYABLE(Scope)
+    };
+
+private:
+    struct Event
+    {
+        const char* name = nullptr;
+        int64_t startTicks = 0;
+        int64_t endTicks = 0;
+    };
+
+    class Writer;
+
+    // Consumer thread: appends everything the producer has published.
+    void drain();
+
+    static constexpr size_t ringMask = ringSize - 1;
+
+    juce::File file;
+    std::unique_ptr<juce::FileOutputStream> stream;
+    std::vector<Event> ring;
+    int64_t originTicks = 0;
+    double microsPerTick = 0.0;
+    int processId = 0;
+
+    // The producer and consumer indices live on separate cache lines.
+    alignas(64) std::atomic<uint64_t> writeIndex { 0 };
+    alignas(64) std::atomic<uint64_t> readIndex { 0 };
+    alignas(64) std::atomic<uint64_t> dropped { 0 };
+
+    // Declared last so it stops before anything it touches is destroyed.
+    std::unique_ptr<Writer> writer;
+
+    JUCE_DECLARE_NON_COPYABLE(TraceRecorder)
+};
+
+ #define COSMIC_TRACE_CONCAT_INNER(a, b) a##b
+ #define COSMIC_TRACE_CONCAT(a, b) COSMIC_TRACE_CONCAT_INNER(a, b)
+ #define COSMIC_TRACE_SCOPE(recorder, name) \
+    const TraceRecorder::Scope COSMIC_TRACE_CONCAT(cosmicTraceScope, __LINE__) { (recorder), (name) }
+
+#else
+
+ #define COSMIC_TRACE_SCOPE(recorder, name) static_cast<void>(0)
+
+#endif
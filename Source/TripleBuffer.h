@@ -0,0 +1,59 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+// Lock-free single-producer/single-consumer triple buffer. The writer fills
+// getWriteBuffer() and calls publish(); the reader calls acquireLatest() and then
+// reads getReadBuffer() for as long as it likes. Neither side ever waits, and the
+// reader never observes a half-written value. Slots are handed over by index, so
+// nothing is copied on either side.
+template <typename T>
+class TripleBuffer
+{
+public:
+    TripleBuffer() = default;
+
+    // Writer side -----------------------------------------------------------
+    T& getWriteBuffer() noexcept { return buffers[writeIndex]; }
+
+    void publish() noexcept
+    {
+        writeIndex = static_cast<uint8_t>(middle.exchange(static_cast<uint8_t>(writeIndex | newDataFlag),
+                                                          std::memory_order_acq_rel) & indexMask);
+    }
+
+    // Reader side -----------------------------------------------------------
+    // Returns true if a newer slot was swapped in since the last call.
+    bool acquireLatest() noexcept
+    {
+        if ((middle.load(std::memory_order_relaxed) & newDataFlag) == 0)
+            return false;
+
+        readIndex = static_cast<uint8_t>(middle.exchange(readIndex, std::memory_order_acq_rel) & indexMask);
+        return true;
+    }
+
+    const T& getReadBuffer() const noexcept { return buffers[readIndex]; }
+
+    // Only safe while neither side is running, e.g. from a constructor or prepare().
+    template <typename Fn>
+    void forEachBuffer(Fn&& fn)
+    {
+        for (auto& buffer : buffers)
+            fn(buffer);
+    }
+
+private:
+    static constexpr uint8_t indexMask = 0x3;
+    static constexpr uint8_t newDataFlag = 0x4;
+
+    std::array<T, 3> buffers {};
+
+    // The shared index and each side's private index live on separate cache lines
+    // so the producer and consumer never false-share.
+    alignas(64) std::atomic<uint8_t> middle { 1 };
+    alignas(64) uint8_t writeIndex = 0;
+    alignas(64) uint8_t readIndex = 2;
+};
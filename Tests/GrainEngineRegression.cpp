@@ -0,0 +1,275 @@
+// Regression test for block-major grain rendering.
+//
+// Usage: CosmicEngineTest
+//
+// Renders the same noise through GrainEngine and through a plain sample-major
+// reference that spells out the engine's original behaviour with none of its own
+// code: for every sample it runs the spawn accumulator, writes a two-second ring
+// wrapped with a modulo, then walks every grain with the sine-arc window and the
+// cos/sin pan computed directly. Both draw grains from the same seed, so they spawn
+// the same cloud. Every combination of block size, density and pitch below must stay
+// within tolerance of the reference; the exit status is non-zero if any case does not.
+
+#include <juce_dsp/juce_dsp.h>
+
+#include "GrainEngine.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+namespace
+{
+constexpr double sampleRate = 48000.0;
+constexpr int numChannels = 2;
+constexpr int numSamples = 144000; // three seconds, past one trip round the delay ring
+constexpr uint32_t seed = 0x5eed;
+
+constexpr float grainSizeMs = 80.0f;
+constexpr float spreadMs = 35.0f;
+constexpr float scatterMs = 25.0f;
+constexpr float pitchJitter = 2.0f;
+constexpr float feedback = 0.4f;
+// Short enough that fast grains overtake the write head, long enough that slow ones
+// read across the ring's wrap.
+constexpr float delayMs = 50.0f;
+// The engine's default Gravity Envelope amount: a sine arc raised to the power 2.25.
+constexpr float envelopeShape = 0.5f;
+
+// The engine reads its window from an interpolated table and sums grains in another
+// order. Both errors grow with the number of overlapping grains, so the tolerance is
+// a fraction of the reference's peak.
+constexpr float tolerance = 1.0e-4f;
+
+constexpr std::array<int, 6> blockSizes { 1, 16, 37, 64, 256, 1024 };
+constexpr std::array<float, 3> densities { 8.0f, 64.0f, 512.0f };
+constexpr std::array<float, 5> pitches { -12.0f, 0.0f, 0.37f, 7.0f, 12.0f };
+
+struct TestCase
+{
+    int blockSize = 0;
+    float density = 0.0f;
+    float pitch = 0.0f;
+};
+
+constexpr float millisecondsToSamples(float ms)
+{
+    return static_cast<float>((ms / 1000.0f) * static_cast<float>(sampleRate));
+}
+
+juce::AudioBuffer<float> makeNoise()
+{
+    juce::AudioBuffer<float> noise(numChannels, numSamples);
+    juce::Random random(1234);
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            noise.setSample(ch, i, random.nextFloat() - 0.5f);
+    return noise;
+}
+
+int wrap(int index, int length)
+{
+    const auto wrapped = index % length;
+    return wrapped < 0 ? wrapped + length : wrapped;
+}
+
+// The original engine, one grain and one sample at a time: a two-second ring, linear
+// interpolation, the sine arc window and mono grains panned equal-power across a
+// stereo bus.
+class SampleMajorReference
+{
+public:
+    explicit SampleMajorReference(const TestCase& testCase)
+        : density(testCase.density),
+          pitch(testCase.pitch),
+          delayBufferSize(static_cast<int>(millisecondsToSamples(2000.0f))),
+          ring(numChannels, std::vector<float>(static_cast<size_t>(delayBufferSize), 0.0f))
+    {
+        rng.seed(seed);
+    }
+
+    juce::AudioBuffer<float> render(const juce::AudioBuffer<float>& input)
+    {
+        juce::AudioBuffer<float> output(numChannels, input.getNumSamples());
+        output.clear();
+
+        const auto spawnInterval = juce::jmax(1.0f, static_cast<float>(sampleRate) / (density / static_cast<float>(numChannels)));
+        const auto delaySamples = juce::roundToInt(millisecondsToSamples(delayMs));
+
+        for (int sample = 0; sample < input.getNumSamples(); ++sample)
+        {
+            spawnAccumulator += 1.0f;
+            while (spawnAccumulator >= spawnInterval)
+            {
+                spawnAccumulator -= spawnInterval;
+                for (int ch = 0; ch < numChannels; ++ch)
+                    spawnGrain(ch);
+            }
+
+            for (int ch = 0; ch < numChannels; ++ch)
+            {
+                auto& slot = ring[static_cast<size_t>(ch)][static_cast<size_t>(writePosition)];
+                slot = slot * feedback + input.getSample(ch, sample);
+            }
+
+            const auto tap = writePosition - delaySamples;
+
+            for (auto& grain : grains)
+            {
+                const auto& history = ring[static_cast<size_t>(grain.channel)];
+                const auto first = wrap(tap + static_cast<int>(grain.readOffset), delayBufferSize);
+                const auto a = history[static_cast<size_t>(first)];
+                const auto b = history[static_cast<size_t>(wrap(first + 1, delayBufferSize))];
+                const auto grainSample = (a + (b - a) * grain.phase) * window(grain.envelope);
+
+                for (int ch = 0; ch < numChannels; ++ch)
+                    output.getWritePointer(ch)[sample] += grainSample * grain.gains[static_cast<size_t>(ch)];
+
+                grain.envelope += grain.envelopeIncrement;
+                grain.phase += grain.advance;
+                const auto whole = std::trunc(grain.phase);
+                grain.phase -= whole;
+                grain.readOffset += whole;
+            }
+
+            writePosition = (writePosition + 1) % delayBufferSize;
+            ++sampleClock;
+            grains.erase(std::remove_if(grains.begin(), grains.end(),
+                                        [this](const Grain& grain) { return grain.endSample <= sampleClock; }),
+                         grains.end());
+        }
+
+        return output;
+    }
+
+private:
+    struct Grain
+    {
+        float readOffset = 0.0f;
+        float phase = 0.0f;
+        float advance = 0.0f;
+        float envelope = 0.0f;
+        float envelopeIncrement = 0.0f;
+        std::array<float, numChannels> gains {};
+        int channel = 0;
+        int64_t endSample = 0;
+    };
+
+    static float window(float position)
+    {
+        const auto base = std::sin(juce::jlimit(0.0f, 1.0f, position) * juce::MathConstants<float>::pi);
+        return base <= 0.0f ? 0.0f : std::pow(base, juce::jmap(envelopeShape, 0.5f, 4.0f));
+    }
+
+    // The same draws, in the same order, as GrainEngine::spawnGrain().
+    void spawnGrain(int channel)
+    {
+        const auto scatterSamples = static_cast<size_t>(juce::roundToInt(
+            std::min(millisecondsToSamples(scatterMs), static_cast<float>(delayBufferSize))));
+
+        const auto lengthMs = juce::jmax(10.0f, grainSizeMs + (randomDist(rng) - 0.5f) * spreadMs);
+        const auto length = std::max<int64_t>(32, static_cast<int64_t>(millisecondsToSamples(lengthMs)));
+        const auto jitterAmount = (randomDist(rng) - 0.5f) * pitchJitter;
+        const auto rate = std::pow(2.0f, (pitch + jitterAmount) / 12.0f);
+        const auto pan = juce::jlimit(0.0f, 1.0f, randomDist(rng));
+        const auto startOffset = scatterSamples > 0 ? static_cast<int>(randomDist(rng) * static_cast<float>(scatterSamples)) : 0;
+
+        Grain grain;
+        grain.readOffset = static_cast<float>(-startOffset);
+        grain.advance = 1.0f + rate;
+        grain.envelopeIncrement = 1.0f / static_cast<float>(length);
+        grain.gains = { std::cos(pan * juce::MathConstants<float>::halfPi), std::sin(pan * juce::MathConstants<float>::halfPi) };
+        grain.channel = channel;
+        grain.endSample = sampleClock + length;
+        grains.push_back(grain);
+    }
+
+    const float density;
+    const float pitch;
+    const int delayBufferSize;
+    std::vector<std::vector<float>> ring;
+    int writePosition = 0;
+    int64_t sampleClock = 0;
+    float spawnAccumulator = 0.0f;
+    std::vector<Grain> grains;
+
+    std::mt19937 rng;
+    std::uniform_real_distribution<float> randomDist { 0.0f, 1.0f };
+};
+
+juce::AudioBuffer<float> renderEngine(const TestCase& testCase, const juce::AudioBuffer<float>& input)
+{
+    GrainEngine engine;
+    engine.setGrainSize(grainSizeMs);
+    engine.setSpread(spreadMs);
+    engine.setScatter(scatterMs);
+    engine.setPitchJitter(pitchJitter);
+    engine.setFeedback(feedback);
+    engine.setDelayTime(delayMs);
+    engine.setEnvelopeShape(envelopeShape);
+    engine.setDensity(testCase.density);
+    engine.setPitch(testCase.pitch);
+    engine.prepare({ sampleRate, static_cast<juce::uint32>(testCase.blockSize), static_cast<juce::uint32>(numChannels) });
+    engine.getGovernor().setEnabled(false);
+    engine.setRandomSeed(seed);
+    engine.reset();
+
+    juce::AudioBuffer<float> output(input);
+    for (int start = 0; start < numSamples; start += testCase.blockSize)
+    {
+        const auto blockLength = juce::jmin(testCase.blockSize, numSamples - start);
+        juce::AudioBuffer<float> block(output.getArrayOfWritePointers(), numChannels, start, blockLength);
+        engine.processBlock(block);
+    }
+    return output;
+}
+
+float maxAbsDifference(const juce::AudioBuffer<float>& a, const juce::AudioBuffer<float>& b)
+{
+    auto difference = 0.0f;
+    for (int ch = 0; ch < numChannels; ++ch)
+        for (int i = 0; i < numSamples; ++i)
+            difference = juce::jmax(difference, std::abs(a.getSample(ch, i) - b.getSample(ch, i)));
+    return difference;
+}
+}
+
+int main()
+{
+    const auto input = makeNoise();
+    int failures = 0;
+
+    std::printf("%5s %7s %6s | %12s %12s\n", "block", "density", "pitch", "peak", "max diff");
+
+    for (const auto density : densities)
+    {
+        for (const auto pitch : pitches)
+        {
+            // The reference does not depend on the block size.
+            const auto reference = SampleMajorReference({ 0, density, pitch }).render(input);
+            const auto peak = reference.getMagnitude(0, numSamples);
+
+            for (const auto blockSize : blockSizes)
+            {
+                const auto difference = maxAbsDifference(renderEngine({ blockSize, density, pitch }, input), reference);
+                const auto passed = difference <= tolerance * peak;
+                failures += passed ? 0 : 1;
+
+                std::printf("%5d %7.1f %6.2f | %12.6f %12.3e %s\n", blockSize, density, pitch, peak, difference,
+                            passed ? "" : "FAIL");
+            }
+        }
+    }
+
+    if (failures > 0)
+    {
+        std::fprintf(stderr, "CosmicEngineTest: %d case(s) differ by more than %g of the peak\n", failures, static_cast<double>(tolerance));
+        return 1;
+    }
+
+    std::printf("All cases within %g of the sample-major reference's peak.\n", static_cast<double>(tolerance));
+    return 0;
+}